@@ -0,0 +1,204 @@
+// Micro-benchmark: runtime-branching pricing loop (one string compare per
+// Greek, as in the original /price loop) vs the templated kernels of
+// bs_kernels.hpp. Every Greek subset is compared with a runtime loop asked
+// for the same subset. The templated rows include what scoreOptionChain pays
+// around the kernels on each call: copying contracts (three strings each),
+// the call/put partition and the scatter back to chain order. A
+// kernels-only row shows how much of the time that overhead takes.
+//
+//   bench_kernels [--contracts 200000] [--reps 20]
+
+#include "black_scholes.hpp"
+#include "bs_kernels.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Chain {
+	std::vector<std::string> type, symbol, expiration;
+	std::vector<double> S, K, sigma, T;
+};
+
+struct Side {
+	std::vector<double> S, K, sigma, T;
+	std::vector<GreekValues> out;
+};
+
+static Chain makeChain(size_t n) {
+	std::mt19937_64 rng(42);
+	std::uniform_real_distribution<double> moneyness(0.6, 1.4), vol(0.1, 0.8), maturity(0.02, 2.0);
+
+	Chain c;
+	for (size_t i = 0; i < n; ++i) {
+		double S = 100.0;
+		c.type.push_back(i % 2 == 0 ? "call" : "put");
+		c.symbol.push_back("AAPL");
+		c.expiration.push_back("2026-12-18");
+		c.S.push_back(S);
+		c.K.push_back(S * moneyness(rng));
+		c.sigma.push_back(vol(rng));
+		c.T.push_back(maturity(rng));
+	}
+	return c;
+}
+
+// Original loop shape: the three strings are copied out of the chain, then
+// every output re-derives d1/d2 and re-tests the type. `mask` selects the
+// outputs at run time, like a caller needing fewer Greeks.
+static double runtimeBranching(const Chain& c, double r, unsigned mask) {
+	double sum = 0.0;
+	for (size_t i = 0; i < c.type.size(); ++i) {
+		std::string opt_type = c.type[i];
+		std::string sym = c.symbol[i];
+		std::string expiration = c.expiration[i];
+		double S = c.S[i], K = c.K[i], sigma = c.sigma[i], T = c.T[i];
+
+		if (mask & Greek::Price)
+			sum += (opt_type == "call") ? blackScholesCall(S, K, r, sigma, T) : blackScholesPut(S, K, r, sigma, T);
+		if (mask & Greek::Delta)
+			sum += (opt_type == "call") ? deltaCall(S, K, r, sigma, T) : deltaPut(S, K, r, sigma, T);
+		if (mask & Greek::Gamma)
+			sum += gamma(S, K, r, sigma, T);
+		if (mask & Greek::Theta)
+			sum += (opt_type == "call") ? thetaCall(S, K, r, sigma, T) : thetaPut(S, K, r, sigma, T);
+		if (mask & Greek::Rho)
+			sum += (opt_type == "call") ? rhoCall(S, K, r, sigma, T) : rhoPut(S, K, r, sigma, T);
+		if (mask & Greek::Vega)
+			sum += vega(S, K, r, sigma, T);
+		if (mask & Greek::ProbITM)
+			sum += brownProb(S, K, r, sigma, T, opt_type);
+		sum += static_cast<double>(sym.size() + expiration.size());
+	}
+	return sum;
+}
+
+static double sumGreeks(const GreekValues& g) {
+	return g.price + g.delta + g.gamma + g.theta + g.rho + g.vega + g.prob_ITM;
+}
+
+// Kernels alone, on batches partitioned once outside the timed region.
+template <unsigned Mask>
+static double kernelsOnly(Side& calls, Side& puts, double r) {
+	bsKernelBatch<OptionType::Call, Mask>(calls.S.data(), calls.K.data(), calls.sigma.data(), calls.T.data(),
+		r, calls.out.size(), calls.out.data());
+	bsKernelBatch<OptionType::Put, Mask>(puts.S.data(), puts.K.data(), puts.sigma.data(), puts.T.data(),
+		r, puts.out.size(), puts.out.data());
+
+	double sum = 0.0;
+	for (const Side* side : { &calls, &puts })
+		for (const auto& g : side->out)
+			sum += sumGreeks(g);
+	return sum;
+}
+
+// Phases 2 and 3 of scoreOptionChain, minus JSON parsing: contract copies,
+// call/put partition, kernels and scatter back to chain order.
+template <unsigned Mask>
+static double pipeline(const Chain& c, double r) {
+	struct Contract {
+		std::string opt_type, sym, expiration;
+		double K, S, sigma, T;
+		bool is_call;
+	};
+	struct Batch {
+		std::vector<size_t> index;
+		std::vector<double> S, K, sigma, T;
+		std::vector<GreekValues> greeks;
+	};
+
+	std::vector<Contract> contracts;
+	contracts.reserve(c.type.size());
+	Batch calls, puts;
+	for (size_t i = 0; i < c.type.size(); ++i) {
+		Contract ct{ c.type[i], c.symbol[i], c.expiration[i], c.K[i], c.S[i], c.sigma[i], c.T[i], c.type[i] == "call" };
+		Batch& b = ct.is_call ? calls : puts;
+		b.index.push_back(contracts.size());
+		b.S.push_back(ct.S);
+		b.K.push_back(ct.K);
+		b.sigma.push_back(ct.sigma);
+		b.T.push_back(ct.T);
+		contracts.push_back(std::move(ct));
+	}
+
+	calls.greeks.resize(calls.index.size());
+	bsKernelBatch<OptionType::Call, Mask>(calls.S.data(), calls.K.data(), calls.sigma.data(), calls.T.data(),
+		r, calls.index.size(), calls.greeks.data());
+	puts.greeks.resize(puts.index.size());
+	bsKernelBatch<OptionType::Put, Mask>(puts.S.data(), puts.K.data(), puts.sigma.data(), puts.T.data(),
+		r, puts.index.size(), puts.greeks.data());
+
+	std::vector<GreekValues> greeks(contracts.size());
+	for (const Batch* b : { &calls, &puts })
+		for (size_t j = 0; j < b->index.size(); ++j)
+			greeks[b->index[j]] = b->greeks[j];
+
+	double sum = 0.0;
+	for (size_t i = 0; i < contracts.size(); ++i)
+		sum += sumGreeks(greeks[i]) + static_cast<double>(contracts[i].sym.size() + contracts[i].expiration.size());
+	return sum;
+}
+
+template <class F>
+static double nsPerContract(F&& f, size_t n, int reps, double& checksum) {
+	checksum += f();   // warm-up
+	auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < reps; ++i)
+		checksum += f();
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+	return elapsed / (static_cast<double>(n) * reps);
+}
+
+int main(int argc, char** argv) {
+	size_t n = 200000;
+	int reps = 20;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string flag = argv[i];
+		if (flag == "--contracts") n = std::stoul(argv[i + 1]);
+		else if (flag == "--reps") reps = std::stoi(argv[i + 1]);
+	}
+
+	const double r = 0.01;
+	Chain chain = makeChain(n);
+
+	Side calls, puts;
+	for (size_t i = 0; i < n; ++i) {
+		Side& side = (chain.type[i] == "call") ? calls : puts;
+		side.S.push_back(chain.S[i]);
+		side.K.push_back(chain.K[i]);
+		side.sigma.push_back(chain.sigma[i]);
+		side.T.push_back(chain.T[i]);
+	}
+	calls.out.resize(calls.S.size());
+	puts.out.resize(puts.S.size());
+
+	constexpr unsigned PriceDelta = Greek::Price | Greek::Delta;
+	double checksum = 0.0;
+	auto time = [&](auto&& f) { return nsPerContract(f, n, reps, checksum); };
+
+	double base_all = time([&] { return runtimeBranching(chain, r, Greek::All); });
+	double kern_all = time([&] { return kernelsOnly<Greek::All>(calls, puts, r); });
+	double pipe_all = time([&] { return pipeline<Greek::All>(chain, r); });
+	double base_pd = time([&] { return runtimeBranching(chain, r, PriceDelta); });
+	double pipe_pd = time([&] { return pipeline<PriceDelta>(chain, r); });
+	double base_p = time([&] { return runtimeBranching(chain, r, Greek::Price); });
+	double pipe_p = time([&] { return pipeline<Greek::Price>(chain, r); });
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "contracts=" << n << " reps=" << reps << "\n";
+	std::cout << std::left << std::setw(40) << "kernel" << std::setw(14) << "ns/contract" << "vs runtime, same Greeks\n";
+	auto row = [&](const char* name, double ns, double base) {
+		std::cout << std::left << std::setw(40) << name << std::setw(14) << ns << (base / ns) << "x\n";
+	};
+	row("runtime branching All", base_all, base_all);
+	row("templated All (kernels only)", kern_all, base_all);
+	row("templated All (+copy/partition/scatter)", pipe_all, base_all);
+	row("runtime branching Price|Delta", base_pd, base_pd);
+	row("templated Price|Delta (+copy/partition)", pipe_pd, base_pd);
+	row("runtime branching Price", base_p, base_p);
+	row("templated Price (+copy/partition)", pipe_p, base_p);
+	std::cout << "checksum=" << checksum << std::endl;
+	return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef BS_KERNELS_HPP
+#define BS_KERNELS_HPP
+
+#include <cmath>
+#include <cstddef>
+
+// Compile-time specialized Black-Scholes kernels. The option type and the set
+// of requested outputs are template parameters, so each instantiation only
+// evaluates the terms it needs (d1/d2, discount factor, pdf and cdf values are
+// shared) and contains no per-contract branch on the option type.
+// Results match the scalar functions of black_scholes.hpp.
+
+enum class OptionType { Call, Put };
+
+namespace Greek {
+	constexpr unsigned Price = 1u << 0;
+	constexpr unsigned Delta = 1u << 1;
+	constexpr unsigned Gamma = 1u << 2;
+	constexpr unsigned Vega = 1u << 3;
+	constexpr unsigned Theta = 1u << 4;
+	constexpr unsigned Rho = 1u << 5;
+	constexpr unsigned ProbITM = 1u << 6;   // same as brownProb(S, K, ...)
+	constexpr unsigned All = Price | Delta | Gamma | Vega | Theta | Rho | ProbITM;
+}
+
+struct GreekValues {
+	double price = 0.0;
+	double delta = 0.0;
+	double gamma = 0.0;
+	double vega = 0.0;
+	double theta = 0.0;
+	double rho = 0.0;
+	double prob_ITM = 0.0;
+};
+
+namespace bs_detail {
+	constexpr double INV_SQRT_2 = 0.70710678118654752440;
+	constexpr double INV_SQRT_2PI = 0.39894228040143267794;
+
+	inline double cdf(double x) { return 0.5 * std::erfc(-x * INV_SQRT_2); }
+	inline double pdf(double x) { return INV_SQRT_2PI * std::exp(-0.5 * x * x); }
+
+	constexpr bool any(unsigned mask, unsigned bits) { return (mask & bits) != 0; }
+}
+
+template <OptionType Type, unsigned Mask>
+inline GreekValues bsKernel(double S, double K, double r, double sigma, double T) {
+	using namespace bs_detail;
+	static_assert((Mask & ~Greek::All) == 0, "unknown Greek bit");
+	constexpr bool call = (Type == OptionType::Call);
+
+	constexpr bool need_df = any(Mask, Greek::Price | Greek::Theta | Greek::Rho);
+	constexpr bool need_pdf = any(Mask, Greek::Gamma | Greek::Vega | Greek::Theta);
+	constexpr bool need_n1 = any(Mask, Greek::Price | Greek::Delta);
+	constexpr bool need_n2 = any(Mask, Greek::Price | Greek::Theta | Greek::Rho | Greek::ProbITM);
+
+	GreekValues g;
+	const double sqrtT = std::sqrt(T);
+	const double vol_sqrtT = sigma * sqrtT;
+	const double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / vol_sqrtT;
+	const double d2 = d1 - vol_sqrtT;
+
+	double df = 0.0, pdf_d1 = 0.0, n1 = 0.0, n2 = 0.0;
+	if constexpr (need_df) df = std::exp(-r * T);
+	if constexpr (need_pdf) pdf_d1 = pdf(d1);
+	// Calls use N(d1), N(d2); puts use N(-d1), N(-d2).
+	if constexpr (need_n1) n1 = call ? cdf(d1) : cdf(-d1);
+	if constexpr (need_n2) n2 = call ? cdf(d2) : cdf(-d2);
+
+	if constexpr (any(Mask, Greek::Price))
+		g.price = call ? S * n1 - K * df * n2 : K * df * n2 - S * n1;
+	if constexpr (any(Mask, Greek::Delta))
+		g.delta = call ? n1 : -n1;   // N(d1) - 1 == -N(-d1)
+	if constexpr (any(Mask, Greek::Gamma))
+		g.gamma = pdf_d1 / (S * vol_sqrtT);
+	if constexpr (any(Mask, Greek::Vega))
+		g.vega = S * pdf_d1 * sqrtT;
+	if constexpr (any(Mask, Greek::Theta))
+		g.theta = -(S * pdf_d1 * sigma) / (2 * sqrtT) + (call ? -r * K * df * n2 : r * K * df * n2);
+	if constexpr (any(Mask, Greek::Rho))
+		g.rho = call ? K * T * df * n2 : -K * T * df * n2;
+	if constexpr (any(Mask, Greek::ProbITM))
+		g.prob_ITM = (K > 0 && sigma > 0 && T > 0) ? n2 : 0.0;
+
+	return g;
+}
+
+// Same option type for the whole batch: partition a chain into calls and puts
+// first, then run one instantiation per side.
+template <OptionType Type, unsigned Mask>
+inline void bsKernelBatch(const double* S, const double* K, const double* sigma, const double* T,
+	double r, std::size_t n, GreekValues* out)
+{
+	for (std::size_t i = 0; i < n; ++i)
+		out[i] = bsKernel<Type, Mask>(S[i], K[i], r, sigma[i], T[i]);
+}
+
+#endif
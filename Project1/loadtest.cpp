@@ -0,0 +1,437 @@
+// Load generator for the Crow server. Each client thread keeps one cpr::Session
+// (keep-alive) and issues /price or /historical requests drawn from a weighted
+// symbol and endpoint mix, either closed-loop (--rate 0) or paced to a global
+// request rate. With a rate, latency is measured from the scheduled send time
+// so queueing behind a saturated server is not hidden. Latency covers every
+// completed request, errors and timeouts included; successful and failed
+// requests are also summarized separately and timeouts are counted.
+//
+//   loadtest [--url http://localhost:8080] [--concurrency 16] [--rate 0]
+//            [--duration-s 10] [--warmup-s 1] [--r 0.01] [--timeout-ms 30000]
+//            [--symbols AAPL:3,MSFT:1] [--endpoints price:9,historical:1]
+//            [--out loadtest_report.json]
+//
+// Worker-thread sweep (POSIX only): starts the server once per thread count,
+// optionally behind a local mock_upstream, and reports the knee of the
+// throughput curve and, with --slo-p99-ms, the largest thread count where 99%
+// of requests succeed within that latency. Each server gets SERVER_THREADS, SERVER_PORT, UPSTREAM_URL,
+// UPSTREAM_POOL (= thread count, so the upstream pool never caps the sweep),
+// HISTORICAL_CSV (--historical-csv, required to sweep /historical) and empty
+// SCAN_SYMBOLS / SESSION_RECORD_FILE, whatever .env says. The mock runs
+// --mock-threads workers (default: the largest sweep value) so it is not the
+// bottleneck either. Both are written to the report config.
+//
+//            --sweep-threads 1,2,4,8 --server ./api_cpp [--server-port 18080]
+//            [--mock ./mock_upstream] [--mock-port 18000] [--mock-latency-ms 20]
+//            [--mock-threads N] [--historical-csv FILE] [--slo-p99-ms 0]
+
+#include <cpr/cpr.h>
+#include <nlohmann/json.hpp>
+#include "process_util.hpp"
+#include "settings.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct WeightedChoice {
+	std::vector<std::string> values;
+	std::vector<double> weights;
+};
+
+struct LoadOptions {
+	std::string url = "http://localhost:8080";
+	int concurrency = 16;
+	double rate = 0.0;                 // total requests/s, 0 = as fast as possible
+	double duration_s = 10.0;
+	double warmup_s = 1.0;
+	double r = 0.01;
+	int timeout_ms = 30000;
+	WeightedChoice symbols;
+	WeightedChoice endpoints;
+	std::string out = "loadtest_report.json";
+
+	std::vector<int> sweep_threads;
+	std::string server;
+	int server_port = 18080;
+	std::string mock;
+	int mock_port = 18000;
+	int mock_latency_ms = 20;
+	int mock_threads = 0;              // 0 = largest --sweep-threads value
+	std::string historical_csv;
+	double slo_p99_ms = 0.0;           // 0 = no SLO
+};
+
+struct RunResult {
+	double duration_s = 0.0;
+	size_t requests = 0;
+	size_t errors = 0;
+	size_t timeouts = 0;                // client-side timeouts (--timeout-ms), also counted in errors
+	std::map<long, size_t> status_codes;
+	std::vector<double> latency_ms;     // every completed request
+	std::vector<double> ok_latency_ms;
+	std::vector<double> error_latency_ms;
+};
+
+// "AAPL:3,MSFT" -> AAPL weight 3, MSFT weight 1
+static WeightedChoice parseMix(const std::string& value) {
+	WeightedChoice mix;
+	for (const auto& item : splitList(value)) {
+		auto colon = item.find(':');
+		mix.values.push_back(item.substr(0, colon));
+		mix.weights.push_back(colon == std::string::npos ? 1.0 : std::stod(item.substr(colon + 1)));
+	}
+	return mix;
+}
+
+static LoadOptions parseArgs(int argc, char** argv) {
+	LoadOptions opts;
+	opts.symbols = parseMix("AAPL");
+	opts.endpoints = parseMix("price");
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string flag = argv[i];
+		std::string value = argv[i + 1];
+
+		if (flag == "--url") opts.url = value;
+		else if (flag == "--concurrency") opts.concurrency = std::max(1, std::stoi(value));
+		else if (flag == "--rate") opts.rate = std::stod(value);
+		else if (flag == "--duration-s") opts.duration_s = std::stod(value);
+		else if (flag == "--warmup-s") opts.warmup_s = std::stod(value);
+		else if (flag == "--r") opts.r = std::stod(value);
+		else if (flag == "--timeout-ms") opts.timeout_ms = std::max(1, std::stoi(value));
+		else if (flag == "--symbols") opts.symbols = parseMix(value);
+		else if (flag == "--endpoints") opts.endpoints = parseMix(value);
+		else if (flag == "--out") opts.out = value;
+		else if (flag == "--sweep-threads") {
+			for (const auto& t : splitList(value))
+				opts.sweep_threads.push_back(std::stoi(t));
+		}
+		else if (flag == "--server") opts.server = value;
+		else if (flag == "--server-port") opts.server_port = std::stoi(value);
+		else if (flag == "--mock") opts.mock = value;
+		else if (flag == "--mock-port") opts.mock_port = std::stoi(value);
+		else if (flag == "--mock-latency-ms") opts.mock_latency_ms = std::stoi(value);
+		else if (flag == "--mock-threads") opts.mock_threads = std::max(1, std::stoi(value));
+		else if (flag == "--historical-csv") opts.historical_csv = value;
+		else if (flag == "--slo-p99-ms") opts.slo_p99_ms = std::stod(value);
+		else throw std::invalid_argument("unknown flag " + flag);
+	}
+
+	if (opts.symbols.values.empty() || opts.endpoints.values.empty())
+		throw std::invalid_argument("empty --symbols or --endpoints mix");
+	for (const auto& e : opts.endpoints.values)
+		if (e != "price" && e != "historical")
+			throw std::invalid_argument("unknown endpoint " + e);
+	if (!opts.sweep_threads.empty() && opts.server.empty())
+		throw std::invalid_argument("--sweep-threads needs --server");
+
+	if (!opts.sweep_threads.empty()) {
+		// The server default points at a Windows path: without a CSV every
+		// /historical request of the sweep would be a 500.
+		bool historical = std::find(opts.endpoints.values.begin(), opts.endpoints.values.end(), "historical")
+			!= opts.endpoints.values.end();
+		if (historical && opts.historical_csv.empty())
+			throw std::invalid_argument("--endpoints historical in a sweep needs --historical-csv");
+
+		int largest = *std::max_element(opts.sweep_threads.begin(), opts.sweep_threads.end());
+		if (opts.mock_threads == 0)
+			opts.mock_threads = largest;
+		else if (opts.mock_threads < largest)
+			std::cerr << "loadtest: --mock-threads " << opts.mock_threads << " < " << largest
+				<< " server threads, the mock will cap the sweep" << std::endl;
+		if (opts.concurrency <= largest)
+			std::cerr << "loadtest: --concurrency " << opts.concurrency << " <= " << largest
+				<< " server threads, the clients cannot keep every thread busy" << std::endl;
+	}
+	return opts;
+}
+
+static RunResult runLoad(const LoadOptions& opts, const std::string& base_url) {
+	const auto start = Clock::now();
+	const auto measure_from = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opts.warmup_s));
+	const auto stop_at = measure_from + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opts.duration_s));
+
+	// With a target rate, client c sends at start + (c + k * concurrency) / rate.
+	const bool paced = opts.rate > 0.0;
+	const auto interval = paced
+		? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opts.concurrency / opts.rate))
+		: Clock::duration::zero();
+
+	std::vector<RunResult> partial(opts.concurrency);
+	std::vector<std::thread> clients;
+
+	for (int c = 0; c < opts.concurrency; ++c) {
+		clients.emplace_back([&, c] {
+			RunResult& res = partial[c];
+			std::mt19937 rng(1234u + c);
+			std::discrete_distribution<size_t> pick_symbol(opts.symbols.weights.begin(), opts.symbols.weights.end());
+			std::discrete_distribution<size_t> pick_endpoint(opts.endpoints.weights.begin(), opts.endpoints.weights.end());
+
+			cpr::Session session;
+			session.SetTimeout(cpr::Timeout{ std::chrono::milliseconds(opts.timeout_ms) });
+
+			auto next = start + (paced ? std::chrono::duration_cast<Clock::duration>(
+				std::chrono::duration<double>(c / opts.rate)) : Clock::duration::zero());
+
+			while (true) {
+				if (paced) {
+					std::this_thread::sleep_until(next);
+				}
+				auto scheduled = paced ? next : Clock::now();
+				if (scheduled >= stop_at) break;
+				next += interval;
+
+				const std::string& endpoint = opts.endpoints.values[pick_endpoint(rng)];
+				const std::string& symbol = opts.symbols.values[pick_symbol(rng)];
+				session.SetUrl(cpr::Url{ base_url + "/" + endpoint });
+				session.SetParameters(cpr::Parameters{ {"symbol", symbol}, {"r", std::to_string(opts.r)} });
+
+				auto response = session.Get();
+				auto done = Clock::now();
+				if (scheduled < measure_from) continue;
+
+				double latency = std::chrono::duration<double, std::milli>(done - scheduled).count();
+				res.requests++;
+				res.status_codes[response.status_code]++;
+				res.latency_ms.push_back(latency);
+				if (response.error || response.status_code != 200) {
+					res.errors++;
+					res.error_latency_ms.push_back(latency);
+					if (response.error.code == cpr::ErrorCode::OPERATION_TIMEDOUT)
+						res.timeouts++;
+				}
+				else {
+					res.ok_latency_ms.push_back(latency);
+				}
+			}
+		});
+	}
+	for (auto& t : clients)
+		t.join();
+
+	RunResult total;
+	total.duration_s = opts.duration_s;
+	for (auto& p : partial) {
+		total.requests += p.requests;
+		total.errors += p.errors;
+		total.timeouts += p.timeouts;
+		for (auto& [code, n] : p.status_codes)
+			total.status_codes[code] += n;
+		total.latency_ms.insert(total.latency_ms.end(), p.latency_ms.begin(), p.latency_ms.end());
+		total.ok_latency_ms.insert(total.ok_latency_ms.end(), p.ok_latency_ms.begin(), p.ok_latency_ms.end());
+		total.error_latency_ms.insert(total.error_latency_ms.end(), p.error_latency_ms.begin(), p.error_latency_ms.end());
+	}
+	return total;
+}
+
+static nlohmann::json latencySummary(std::vector<double>& lat) {
+	std::sort(lat.begin(), lat.end());
+	auto pct = [&](double p) {
+		return lat.empty() ? 0.0 : lat[std::min(lat.size() - 1, static_cast<size_t>(p * lat.size()))];
+	};
+	double sum = 0.0;
+	for (double v : lat) sum += v;
+
+	return {
+		{ "count", lat.size() },
+		{ "mean", lat.empty() ? 0.0 : sum / lat.size() },
+		{ "p50", pct(0.50) },
+		{ "p90", pct(0.90) },
+		{ "p99", pct(0.99) },
+		{ "p999", pct(0.999) },
+		{ "max", lat.empty() ? 0.0 : lat.back() },
+	};
+}
+
+// With an SLO, also reports the share of requests that succeeded within it:
+// a failed request never meets the SLO, however fast it failed.
+static nlohmann::json summarize(RunResult& run, double slo_p99_ms) {
+	nlohmann::json j;
+	j["duration_s"] = run.duration_s;
+	j["requests"] = run.requests;
+	j["errors"] = run.errors;
+	j["timeouts"] = run.timeouts;
+	j["throughput_rps"] = run.duration_s > 0 ? (run.requests - run.errors) / run.duration_s : 0.0;
+	j["latency_ms"] = latencySummary(run.latency_ms);
+	j["ok_latency_ms"] = latencySummary(run.ok_latency_ms);
+	j["error_latency_ms"] = latencySummary(run.error_latency_ms);
+	if (slo_p99_ms > 0) {
+		size_t within = std::count_if(run.ok_latency_ms.begin(), run.ok_latency_ms.end(),
+			[&](double v) { return v <= slo_p99_ms; });
+		j["within_slo"] = run.requests ? static_cast<double>(within) / run.requests : 0.0;
+	}
+	for (auto& [code, n] : run.status_codes)
+		j["status_codes"][std::to_string(code)] = n;
+	return j;
+}
+
+static void printRun(const nlohmann::json& run) {
+	const auto& lat = run["latency_ms"];
+	std::cout << "  " << run["throughput_rps"].get<double>() << " req/s, p50 " << lat["p50"].get<double>()
+		<< " ms, p99 " << lat["p99"].get<double>() << " ms, p999 " << lat["p999"].get<double>()
+		<< " ms, errors " << run["errors"].get<size_t>() << "/" << run["requests"].get<size_t>()
+		<< " (" << run["timeouts"].get<size_t>() << " timeouts)" << std::endl;
+}
+
+#ifndef _WIN32
+// First thread count after which doubling the pool buys < 10% throughput.
+static int findKnee(const nlohmann::json& runs) {
+	for (size_t i = 0; i + 1 < runs.size(); ++i) {
+		double here = runs[i]["throughput_rps"].get<double>();
+		double next = runs[i + 1]["throughput_rps"].get<double>();
+		if (next < here * 1.10)
+			return runs[i]["server_threads"].get<int>();
+	}
+	return runs.empty() ? 0 : runs.back()["server_threads"].get<int>();
+}
+
+// Largest thread count where 99% of requests succeeded within the SLO; 0 if none.
+static int findSloThreads(const nlohmann::json& runs) {
+	int best = 0;
+	for (const auto& run : runs)
+		if (run["within_slo"].get<double>() >= 0.99)
+			best = std::max(best, run["server_threads"].get<int>());
+	return best;
+}
+
+// Fills `sweep` (report config) with the child process setup.
+static nlohmann::json runSweep(const LoadOptions& opts, nlohmann::json& sweep) {
+	pid_t mock_pid = -1;
+	std::string upstream_url = readSetting("UPSTREAM_URL").value_or("http://localhost:8000");
+
+	sweep["server_threads"] = opts.sweep_threads;
+	sweep["server"] = opts.server;
+	sweep["server_port"] = opts.server_port;
+
+	if (!opts.mock.empty()) {
+		mock_pid = spawnProcess({ opts.mock, "--port", std::to_string(opts.mock_port),
+			"--threads", std::to_string(opts.mock_threads),
+			"--latency-ms", std::to_string(opts.mock_latency_ms) });
+		upstream_url = "http://localhost:" + std::to_string(opts.mock_port);
+		if (!waitForHttp(upstream_url + "/ticker")) {
+			terminateProcess(mock_pid);
+			throw std::runtime_error("mock upstream did not start");
+		}
+		sweep["mock"] = opts.mock;
+		sweep["mock_port"] = opts.mock_port;
+		sweep["mock_threads"] = opts.mock_threads;
+		sweep["mock_latency_ms"] = opts.mock_latency_ms;
+	}
+	sweep["upstream_url"] = upstream_url;
+	if (!opts.historical_csv.empty())
+		sweep["historical_csv"] = opts.historical_csv;
+
+	const std::string base_url = "http://localhost:" + std::to_string(opts.server_port);
+	nlohmann::json runs = nlohmann::json::array();
+
+	for (int threads : opts.sweep_threads) {
+		// Set explicitly so the server's .env cannot change what is measured
+		std::map<std::string, std::string> env = {
+			{ "SERVER_THREADS", std::to_string(threads) },
+			{ "SERVER_PORT", std::to_string(opts.server_port) },
+			{ "UPSTREAM_URL", upstream_url },
+			{ "UPSTREAM_POOL", std::to_string(threads) },
+			{ "SCAN_SYMBOLS", "" },
+			{ "SESSION_RECORD_FILE", "" },
+		};
+		if (!opts.historical_csv.empty())
+			env["HISTORICAL_CSV"] = opts.historical_csv;
+		if (!readSetting("API_KEY"))
+			env["API_KEY"] = "loadtest";
+
+		pid_t server_pid = spawnProcess({ opts.server }, env);
+		if (!waitForHttp(base_url + "/scan/status")) {
+			terminateProcess(server_pid);
+			std::cerr << "loadtest: server did not start with " << threads << " threads" << std::endl;
+			continue;
+		}
+
+		std::cout << "server_threads=" << threads << std::endl;
+		RunResult result = runLoad(opts, base_url);
+		terminateProcess(server_pid);
+
+		nlohmann::json run = summarize(result, opts.slo_p99_ms);
+		run["server_threads"] = threads;
+		env.erase("API_KEY");
+		run["server_env"] = env;
+		printRun(run);
+		runs.push_back(std::move(run));
+	}
+
+	if (mock_pid > 0)
+		terminateProcess(mock_pid);
+	return runs;
+}
+#endif
+
+int main(int argc, char** argv) {
+	LoadOptions opts;
+	try {
+		opts = parseArgs(argc, argv);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "loadtest: " << e.what() << std::endl;
+		return 2;
+	}
+
+	nlohmann::json report;
+	report["config"] = {
+		{ "concurrency", opts.concurrency },
+		{ "rate", opts.rate },
+		{ "duration_s", opts.duration_s },
+		{ "warmup_s", opts.warmup_s },
+		{ "r", opts.r },
+		{ "timeout_ms", opts.timeout_ms },
+		{ "symbols", opts.symbols.values },
+		{ "symbol_weights", opts.symbols.weights },
+		{ "endpoints", opts.endpoints.values },
+		{ "endpoint_weights", opts.endpoints.weights },
+	};
+
+	try {
+		if (opts.sweep_threads.empty()) {
+			std::cout << opts.url << std::endl;
+			RunResult result = runLoad(opts, opts.url);
+			nlohmann::json run = summarize(result, opts.slo_p99_ms);
+			printRun(run);
+			report["runs"] = nlohmann::json::array({ run });
+		}
+		else {
+#ifndef _WIN32
+			report["runs"] = runSweep(opts, report["config"]["sweep"]);
+			report["knee_threads"] = findKnee(report["runs"]);
+			std::cout << "knee at " << report["knee_threads"].get<int>() << " server threads" << std::endl;
+			if (opts.slo_p99_ms > 0) {
+				report["slo_p99_ms"] = opts.slo_p99_ms;
+				report["slo_threads"] = findSloThreads(report["runs"]);
+				if (report["slo_threads"].get<int>() > 0)
+					std::cout << "p99 <= " << opts.slo_p99_ms << " ms up to " << report["slo_threads"].get<int>()
+						<< " server threads" << std::endl;
+				else
+					std::cout << "no thread count meets p99 <= " << opts.slo_p99_ms << " ms" << std::endl;
+			}
+#else
+			std::cerr << "loadtest: --sweep-threads is not supported on Windows" << std::endl;
+			return 2;
+#endif
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "loadtest: " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::ofstream(opts.out) << report.dump(2) << std::endl;
+	std::cout << "report written to " << opts.out << std::endl;
+	return 0;
+}
@@ -0,0 +1,207 @@
+// Local stand-in for the FastAPI service (fetch_data.py) used by tests, the
+// replay harness and load tests. Serves GET /ticker?symbol=A,B with synthetic
+// but deterministic option chains in the same format as the Python API.
+//
+//   mock_upstream [--port 8000] [--threads N] [--latency-ms 0] [--fail-rate 0.0]
+//                 [--api-key KEY] [--expirations 6] [--strikes 25] [--missing A,B]
+//                 [--symbol-latency-ms A:50,B:600]
+//
+// Symbols listed in --missing answer 404 right away, without the latency.
+// --symbol-latency-ms overrides --latency-ms per symbol (a multi-symbol call
+// waits for its slowest symbol). GET /stats returns the number of /ticker
+// requests received so far, so tests can count retries.
+
+#include <crow.h>
+#include <nlohmann/json.hpp>
+#include "black_scholes.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct MockConfig {
+	int port = 8000;
+	unsigned threads = 4;
+	int latency_ms = 0;
+	double fail_rate = 0.0;
+	std::string api_key;
+	int expirations = 6;
+	int strikes = 25;
+	std::set<std::string> missing;
+	std::map<std::string, int> symbol_latency_ms;
+};
+
+static const int kMaturityDays[] = { 7, 14, 30, 60, 90, 180, 270, 365, 540, 730 };
+
+static std::uint64_t fnv1a(const std::string& s) {
+	std::uint64_t h = 1469598103934665603ULL;
+	for (unsigned char c : s) {
+		h ^= c;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static std::string dateInDays(int days) {
+	std::time_t t = std::time(nullptr) + static_cast<std::time_t>(days) * 24 * 60 * 60;
+	std::tm tm_day = *std::localtime(&t);
+	std::ostringstream ss;
+	ss << std::put_time(&tm_day, "%Y-%m-%d");
+	return ss.str();
+}
+
+static nlohmann::json buildChain(const std::string& symbol, const MockConfig& config, const std::vector<std::string>& expirations) {
+	std::mt19937_64 rng(fnv1a(symbol));
+	std::uniform_real_distribution<double> noise(-0.05, 0.05);
+	std::uniform_int_distribution<int> volume(0, 2000);
+
+	const double spot = 20.0 + static_cast<double>(fnv1a(symbol) % 48000) / 100.0;
+	const double base_iv = 0.18 + static_cast<double>(fnv1a(symbol + "iv") % 30) / 100.0;
+	const double r = 0.01;
+
+	nlohmann::json chain = nlohmann::json::array();
+	for (size_t e = 0; e < expirations.size(); ++e) {
+		const std::string& expiration = expirations[e];
+		const double T = kMaturityDays[e] / 365.0;
+
+		for (int k = 0; k < config.strikes; ++k) {
+			double moneyness = 0.6 + 0.8 * k / std::max(1, config.strikes - 1);
+			double K = std::round(spot * moneyness * 2.0) / 2.0;
+			double sigma = base_iv + 0.35 * (moneyness - 1.0) * (moneyness - 1.0) - 0.05 * (moneyness - 1.0);
+
+			for (const char* type : { "call", "put" }) {
+				bool call = type[0] == 'c';
+				double fair = call ? blackScholesCall(spot, K, r, sigma, T) : blackScholesPut(spot, K, r, sigma, T);
+
+				nlohmann::json opt;
+				opt["symbol"] = symbol;
+				opt["type"] = type;
+				opt["strike"] = K;
+				opt["expiration"] = expiration;
+				opt["impliedVolatility"] = sigma * (1.0 + noise(rng));
+				opt["lastPrice"] = std::max(0.01, fair * (1.0 + noise(rng)));
+				opt["spot"] = spot;
+				opt["volume"] = volume(rng);
+				chain.push_back(std::move(opt));
+			}
+		}
+	}
+	return chain;
+}
+
+static MockConfig parseArgs(int argc, char** argv) {
+	MockConfig config;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string flag = argv[i];
+		std::string value = argv[i + 1];
+
+		if (flag == "--port") config.port = std::stoi(value);
+		else if (flag == "--threads") config.threads = static_cast<unsigned>(std::stoul(value));
+		else if (flag == "--latency-ms") config.latency_ms = std::stoi(value);
+		else if (flag == "--fail-rate") config.fail_rate = std::stod(value);
+		else if (flag == "--api-key") config.api_key = value;
+		else if (flag == "--expirations") config.expirations = std::stoi(value);
+		else if (flag == "--strikes") config.strikes = std::stoi(value);
+		else if (flag == "--missing") {
+			std::stringstream ss(value);
+			std::string sym;
+			while (std::getline(ss, sym, ','))
+				if (!sym.empty()) config.missing.insert(sym);
+		}
+		else if (flag == "--symbol-latency-ms") {
+			std::stringstream ss(value);
+			std::string item;
+			while (std::getline(ss, item, ',')) {
+				auto colon = item.find(':');
+				if (colon == std::string::npos)
+					throw std::invalid_argument("expected SYMBOL:MS in --symbol-latency-ms");
+				config.symbol_latency_ms[item.substr(0, colon)] = std::stoi(item.substr(colon + 1));
+			}
+		}
+		else throw std::invalid_argument("unknown flag " + flag);
+	}
+	return config;
+}
+
+int main(int argc, char** argv) {
+	MockConfig config;
+	try {
+		config = parseArgs(argc, argv);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "mock_upstream: " << e.what() << std::endl;
+		return 2;
+	}
+
+	// Dates are fixed at startup (std::localtime is not thread safe).
+	std::vector<std::string> expirations;
+	for (int e = 0; e < std::min(config.expirations, 10); ++e)
+		expirations.push_back(dateInDays(kMaturityDays[e]));
+
+	std::atomic<unsigned long long> requests{ 0 };
+
+	crow::SimpleApp app;
+	CROW_ROUTE(app, "/ticker").methods("GET"_method)
+		([&config, &expirations, &requests](const crow::request& req) {
+		requests.fetch_add(1);
+		if (!config.api_key.empty() && req.get_header_value("X-API-KEY") != config.api_key)
+			return crow::response(403, "Invalid or missing API key");
+
+		const char* symbol_c = req.url_params.get("symbol");
+		if (!symbol_c)
+			return crow::response(422, "missing param symbol");
+
+		std::vector<std::string> symbols;
+		std::stringstream ss(symbol_c);
+		std::string sym;
+		int latency_ms = 0;
+		while (std::getline(ss, sym, ',')) {
+			if (sym.empty()) continue;
+			if (config.missing.count(sym))
+				return crow::response(404, "No options found for " + sym);
+			auto it = config.symbol_latency_ms.find(sym);
+			latency_ms = std::max(latency_ms, it != config.symbol_latency_ms.end() ? it->second : config.latency_ms);
+			symbols.push_back(sym);
+		}
+
+		if (latency_ms > 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(latency_ms));
+
+		if (config.fail_rate > 0.0) {
+			thread_local std::mt19937 rng(std::random_device{}());
+			if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < config.fail_rate)
+				return crow::response(503, "mock failure");
+		}
+
+		nlohmann::json all = nlohmann::json::array();
+		for (const auto& s : symbols)
+			for (auto& opt : buildChain(s, config, expirations))
+				all.push_back(std::move(opt));
+
+		crow::response res(all.dump());
+		res.set_header("Content-Type", "application/json");
+		return res;
+			});
+
+	CROW_ROUTE(app, "/stats").methods("GET"_method)
+		([&requests]() {
+		crow::json::wvalue stats;
+		stats["requests"] = requests.load();
+		return stats;
+			});
+
+	std::cout << "[mock] Serving /ticker on port " << config.port << std::endl;
+	app.port(static_cast<std::uint16_t>(config.port)).concurrency(config.threads).run();
+	return 0;
+}
@@ -0,0 +1,57 @@
+#include "process_util.hpp"
+
+#ifndef _WIN32
+#include <cpr/cpr.h>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+pid_t spawnProcess(const std::vector<std::string>& args, const std::map<std::string, std::string>& env) {
+	pid_t pid = fork();
+	if (pid == 0) {
+		for (const auto& [name, value] : env)
+			setenv(name.c_str(), value.c_str(), 1);
+		std::vector<char*> argv;
+		for (const auto& a : args)
+			argv.push_back(const_cast<char*>(a.c_str()));
+		argv.push_back(nullptr);
+		execv(argv[0], argv.data());
+		_exit(127);
+	}
+	if (pid < 0)
+		throw std::runtime_error("fork failed for " + args[0]);
+	return pid;
+}
+
+void terminateProcess(pid_t pid) {
+	kill(pid, SIGTERM);
+	for (int i = 0; i < 50; ++i) {
+		if (waitpid(pid, nullptr, WNOHANG) == pid) return;
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	kill(pid, SIGKILL);
+	waitpid(pid, nullptr, 0);
+}
+
+int waitProcess(pid_t pid) {
+	int status = 0;
+	if (waitpid(pid, &status, 0) != pid)
+		throw std::runtime_error("waitpid failed for " + std::to_string(pid));
+	if (WIFEXITED(status)) return WEXITSTATUS(status);
+	if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+	return -1;
+}
+
+bool waitForHttp(const std::string& url) {
+	for (int i = 0; i < 100; ++i) {
+		auto res = cpr::Get(cpr::Url{ url }, cpr::Timeout{ std::chrono::milliseconds(500) });
+		if (!res.error && res.status_code != 0) return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	return false;
+}
+#endif
@@ -0,0 +1,28 @@
+#ifndef PROCESS_UTIL_HPP
+#define PROCESS_UTIL_HPP
+
+// Child process helpers for the load-test sweep and the ctest programs
+// (POSIX only: fork/exec, SIGTERM then SIGKILL).
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Starts args[0] with the given arguments. `env` entries are set on top of the
+// inherited environment; an empty value still overrides the .env file, since
+// readSetting() looks at the environment first.
+pid_t spawnProcess(const std::vector<std::string>& args, const std::map<std::string, std::string>& env = {});
+
+// SIGTERM, then SIGKILL if the child is still alive after 5 s.
+void terminateProcess(pid_t pid);
+
+// Waits for the child to exit; returns its exit status, or 128 + signal.
+int waitProcess(pid_t pid);
+
+// Polls `url` until any HTTP response comes back (10 s max).
+bool waitForHttp(const std::string& url);
+#endif
+
+#endif
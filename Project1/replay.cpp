@@ -0,0 +1,229 @@
+// Replays a recorded session (SESSION_RECORD_FILE) through the /price
+// scoring pipeline without the Python service. Each record holds the chains
+// of one live /price query or scanner snapshot, its rate and its scoring
+// clock, so the rebuilt body must hash to the one that was served, whatever
+// the local time zone.
+//
+//   replay --session FILE [--repeat 1] [--report FILE]
+//
+// Prints per-stage timings and the upstream latencies recorded with each
+// chain; --report writes them as JSON. Exits with status 1 if any rebuilt
+// body differs from the served one.
+
+#include "scoring.hpp"
+#include "session_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using StageClock = std::chrono::steady_clock;
+
+struct ReplayOptions {
+	std::string session;
+	int repeat = 1;
+	std::string report;
+};
+
+struct StageSamples {
+	std::vector<double> us;
+
+	void add(std::chrono::nanoseconds d) { us.push_back(d.count() / 1000.0); }
+
+	nlohmann::json summary() {
+		nlohmann::json j;
+		if (us.empty()) return j;
+		std::sort(us.begin(), us.end());
+		double total = 0.0;
+		for (double v : us) total += v;
+		auto pct = [&](double p) { return us[std::min(us.size() - 1, static_cast<size_t>(p * us.size()))]; };
+
+		j["count"] = us.size();
+		j["mean_us"] = total / us.size();
+		j["p50_us"] = pct(0.50);
+		j["p99_us"] = pct(0.99);
+		j["max_us"] = us.back();
+		j["total_ms"] = total / 1000.0;
+		return j;
+	}
+};
+
+static std::string hex(std::uint64_t h) {
+	std::ostringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << h;
+	return ss.str();
+}
+
+static ReplayOptions parseArgs(int argc, char** argv) {
+	ReplayOptions opts;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string flag = argv[i];
+		std::string value = argv[i + 1];
+
+		if (flag == "--session") opts.session = value;
+		else if (flag == "--repeat") opts.repeat = std::max(1, std::stoi(value));
+		else if (flag == "--report") opts.report = value;
+		else throw std::invalid_argument("unknown flag " + flag);
+	}
+	if (opts.session.empty())
+		throw std::invalid_argument("--session is required");
+	return opts;
+}
+
+int main(int argc, char** argv) {
+	ReplayOptions opts;
+	try {
+		opts = parseArgs(argc, argv);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "replay: " << e.what() << std::endl;
+		return 2;
+	}
+
+	std::ifstream in(opts.session, std::ios::binary);
+	if (!in.is_open()) {
+		std::cerr << "replay: unable to open " << opts.session << std::endl;
+		return 2;
+	}
+
+	std::vector<std::vector<std::uint8_t>> records;
+	try {
+		std::vector<std::uint8_t> bytes;
+		while (readRecordBytes(in, bytes))
+			records.push_back(bytes);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "replay: " << e.what() << " after " << records.size() << " records" << std::endl;
+		return 2;
+	}
+
+	std::map<std::string, StageSamples> stages;
+	StageSamples upstream_chain;   // recorded fetch_us of every chain
+	StageSamples upstream_query;   // slowest chain of each record: when the last one arrived
+	std::vector<std::uint64_t> hashes(records.size());
+	std::map<std::string, size_t> by_source;
+	size_t contracts = 0;
+	size_t mismatches = 0;
+	bool nondeterministic = false;
+
+	auto wall_start = StageClock::now();
+	try {
+		for (int pass = 0; pass < opts.repeat; ++pass) {
+			for (size_t i = 0; i < records.size(); ++i) {
+				auto t0 = StageClock::now();
+				RecordedQuery rec = decodeRecord(records[i]);
+				auto t1 = StageClock::now();
+
+				// Same calls as the live path: every chain scored on the recorded clock
+				GroupedOptions grouped;
+				ScoreTimings total;
+				const std::time_t now = static_cast<std::time_t>(rec.ts_ms / 1000);
+				for (const auto& chain : rec.chains) {
+					ScoreTimings timings;
+					scoreOptionChain(chain.payload, rec.r, grouped, now, &timings);
+					total.iv_surface += timings.iv_surface;
+					total.parse += timings.parse;
+					total.kernels += timings.kernels;
+					total.scoring += timings.scoring;
+				}
+
+				auto t2 = StageClock::now();
+				std::string body = buildPriceResponse(rec.query, grouped).dump();
+				auto t3 = StageClock::now();
+
+				stages["decode"].add(t1 - t0);
+				stages["iv_surface"].add(total.iv_surface);
+				stages["parse"].add(total.parse);
+				stages["kernels"].add(total.kernels);
+				stages["scoring"].add(total.scoring);
+				stages["serialize"].add(t3 - t2);
+				stages["total"].add(t3 - t0);
+
+				std::uint64_t h = fnv1a64(body);
+				if (pass == 0) {
+					hashes[i] = h;
+					++by_source[rec.source];
+					long long slowest = 0;
+					for (const auto& chain : rec.chains) {
+						contracts += chain.payload.size();
+						upstream_chain.add(std::chrono::microseconds(chain.fetch_us));
+						slowest = std::max(slowest, chain.fetch_us);
+					}
+					if (!rec.chains.empty())
+						upstream_query.add(std::chrono::microseconds(slowest));
+					if (h != rec.body_hash) {
+						++mismatches;
+						std::cerr << "replay: record " << i << " (" << rec.source << " " << rec.query
+							<< ") served " << hex(rec.body_hash) << ", replayed " << hex(h) << std::endl;
+					}
+				}
+				else if (hashes[i] != h) {
+					nondeterministic = true;
+				}
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "replay: " << e.what() << std::endl;
+		return 2;
+	}
+	double wall_s = std::chrono::duration<double>(StageClock::now() - wall_start).count();
+
+	int status = 0;
+	if (nondeterministic) {
+		std::cerr << "replay: output changed between passes" << std::endl;
+		status = 1;
+	}
+	if (mismatches)
+		status = 1;
+
+	nlohmann::json report;
+	report["session"] = opts.session;
+	report["records"] = records.size();
+	report["records_by_source"] = by_source;
+	report["contracts"] = contracts;
+	report["repeat"] = opts.repeat;
+	report["wall_s"] = wall_s;
+	report["records_per_s"] = wall_s > 0 ? records.size() * opts.repeat / wall_s : 0.0;
+	report["contracts_per_s"] = wall_s > 0 ? contracts * opts.repeat / wall_s : 0.0;
+	report["deterministic"] = !nondeterministic;
+	report["hash_mismatches"] = mismatches;
+	for (auto& [name, samples] : stages)
+		report["stages"][name] = samples.summary();
+	report["recorded_upstream"]["chain"] = upstream_chain.summary();
+	report["recorded_upstream"]["query"] = upstream_query.summary();
+
+	if (!opts.report.empty())
+		std::ofstream(opts.report) << report.dump(2) << std::endl;
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << records.size() << " records, " << contracts << " contracts, " << opts.repeat << " pass(es), "
+		<< report["records_per_s"].get<double>() << " records/s, " << mismatches << " hash mismatch(es)" << std::endl;
+	std::cout << std::left << std::setw(12) << "stage" << std::right << std::setw(12) << "p50_us"
+		<< std::setw(12) << "p99_us" << std::setw(12) << "total_ms" << std::endl;
+	for (const char* name : { "decode", "iv_surface", "parse", "kernels", "scoring", "serialize", "total" }) {
+		const auto& s = report["stages"][name];
+		if (s.is_null()) continue;
+		std::cout << std::left << std::setw(12) << name << std::right
+			<< std::setw(12) << s["p50_us"].get<double>()
+			<< std::setw(12) << s["p99_us"].get<double>()
+			<< std::setw(12) << s["total_ms"].get<double>() << std::endl;
+	}
+	std::cout << "recorded upstream latency (not replayed):" << std::endl;
+	for (const char* name : { "chain", "query" }) {
+		const auto& s = report["recorded_upstream"][name];
+		if (s.is_null()) continue;
+		std::cout << std::left << std::setw(12) << name << std::right
+			<< std::setw(12) << s["p50_us"].get<double>()
+			<< std::setw(12) << s["p99_us"].get<double>()
+			<< std::setw(12) << s["max_us"].get<double>() / 1000.0 << " max_ms" << std::endl;
+	}
+
+	return status;
+}
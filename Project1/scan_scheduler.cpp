@@ -0,0 +1,270 @@
+#include "scan_scheduler.hpp"
+#include "scoring.hpp"
+#include "session_recorder.hpp"
+#include "settings.hpp"
+#include <algorithm>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+ScanConfig loadScanConfig() {
+	ScanConfig config;
+
+	config.refresh_interval = std::chrono::seconds(std::max(1L, readSettingInt("SCAN_INTERVAL_S", 60)));
+
+	// "AAPL:30,MSFT" -> AAPL every 30 s, MSFT every SCAN_INTERVAL_S
+	if (auto symbols = readSetting("SCAN_SYMBOLS")) {
+		for (const auto& item : splitList(*symbols)) {
+			auto colon = item.find(':');
+			std::string sym = item.substr(0, colon);
+			if (sym.empty() || std::find(config.symbols.begin(), config.symbols.end(), sym) != config.symbols.end())
+				continue;
+			config.symbols.push_back(sym);
+			if (colon != std::string::npos) {
+				try {
+					config.intervals[sym] = std::chrono::seconds(std::max(1L, std::stol(item.substr(colon + 1))));
+				}
+				catch (const std::exception&) {
+					std::cerr << "[C++] Invalid scan interval for " << sym << ", using SCAN_INTERVAL_S" << std::endl;
+				}
+			}
+		}
+	}
+
+	config.r = readSettingDouble("SCAN_RATE", config.r);
+	config.max_upstream = static_cast<size_t>(std::max(1L, readSettingInt("SCAN_MAX_UPSTREAM", 4)));
+	config.workers = static_cast<size_t>(std::max(1L, readSettingInt("SCAN_WORKERS", 2)));
+	return config;
+}
+
+SnapshotSlot::~SnapshotSlot() {
+	delete slots_[0].load();
+	delete slots_[1].load();
+}
+
+void SnapshotSlot::publish(std::unique_ptr<const ScanSnapshot> snap) {
+	const unsigned long long epoch = epoch_.load();
+	const size_t idle = (epoch + 1) & 1;
+
+	// Readers still pinned on the idle slot got there before the last publish
+	// and only hold it while copying a body. Spin briefly, then sleep so a
+	// reader sharing this core gets to run and release it.
+	for (unsigned spins = 0; readers_[idle].load() != 0; ++spins) {
+		if (spins < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+
+	delete slots_[idle].exchange(snap.release());
+	epoch_.store(epoch + 1);
+}
+
+ScanScheduler::ScanScheduler(ScanConfig config, FetchFn fetch, SessionRecorder* recorder)
+	: config_(std::move(config)), fetch_(std::move(fetch)), recorder_(recorder)
+{
+	for (const auto& sym : config_.symbols) {
+		auto interval = config_.intervals.find(sym);
+		states_[sym].refresh_interval = interval != config_.intervals.end() ? interval->second : config_.refresh_interval;
+	}
+}
+
+ScanScheduler::~ScanScheduler() {
+	stop();
+}
+
+void ScanScheduler::start() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (running_ || states_.empty()) return;
+		running_ = true;
+	}
+
+	std::cout << "[C++] Scanner started on " << states_.size() << " symbols, refresh every "
+		<< config_.refresh_interval.count() << "s (" << config_.intervals.size() << " per-symbol overrides)" << std::endl;
+
+	threads_.emplace_back(&ScanScheduler::timerLoop, this);
+	for (size_t i = 0; i < config_.max_upstream; ++i)
+		threads_.emplace_back(&ScanScheduler::fetchLoop, this);
+	for (size_t i = 0; i < config_.workers; ++i)
+		threads_.emplace_back(&ScanScheduler::scoreLoop, this);
+}
+
+void ScanScheduler::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!running_) return;
+		running_ = false;
+	}
+	timer_cv_.notify_all();
+	fetch_cv_.notify_all();
+	score_cv_.notify_all();
+
+	for (auto& t : threads_)
+		t.join();
+	threads_.clear();
+}
+
+void ScanScheduler::timerLoop() {
+	auto tick = std::chrono::seconds(1);
+	for (const auto& [sym, state] : states_)
+		tick = std::min(tick, state.refresh_interval);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (running_) {
+		auto now = Clock::now();
+		bool queued = false;
+
+		for (auto& [sym, state] : states_) {
+			if (state.pending || state.next_due > now) continue;
+			state.pending = true;
+			fetch_queue_.push_back(sym);
+			queued = true;
+		}
+		if (queued)
+			fetch_cv_.notify_all();
+
+		timer_cv_.wait_for(lock, tick, [this] { return !running_; });
+	}
+}
+
+void ScanScheduler::fetchLoop() {
+	while (true) {
+		std::string sym;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			fetch_cv_.wait(lock, [this] { return !running_ || !fetch_queue_.empty(); });
+			if (!running_) return;
+			sym = std::move(fetch_queue_.front());
+			fetch_queue_.pop_front();
+			++fetch_in_flight_;
+		}
+
+		auto t0 = Clock::now();
+		try {
+			auto chain = fetch_(sym);
+			auto fetch_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			--fetch_in_flight_;
+			score_queue_.push_back({ sym, std::move(chain), fetch_time });
+			score_cv_.notify_one();
+		}
+		catch (const std::exception& e) {
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				--fetch_in_flight_;
+			}
+			markFailed(sym, e.what());
+		}
+	}
+}
+
+void ScanScheduler::scoreLoop() {
+	while (true) {
+		ScoreJob job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			score_cv_.wait(lock, [this] { return !running_ || !score_queue_.empty(); });
+			if (!running_) return;
+			job = std::move(score_queue_.front());
+			score_queue_.pop_front();
+			++score_in_flight_;
+		}
+
+		auto t0 = Clock::now();
+		try {
+			const long long ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+
+			GroupedOptions grouped;
+			scoreOptionChain(job.chain, config_.r, grouped, static_cast<std::time_t>(ts_ms / 1000));
+
+			auto snap = std::make_unique<ScanSnapshot>();
+			snap->body = buildPriceResponse(job.symbol, grouped).dump();
+			snap->r = config_.r;
+			snap->scored_at = Clock::now();
+			snap->fetch_time = job.fetch_time;
+			snap->score_time = std::chrono::duration_cast<std::chrono::microseconds>(snap->scored_at - t0);
+
+			if (recorder_) {
+				RecordedQuery rec{ ts_ms, "scan", job.symbol, config_.r, {}, fnv1a64(snap->body) };
+				rec.chains.push_back({ job.symbol, std::move(job.chain), static_cast<long long>(job.fetch_time.count()) });
+				recorder_->record(rec);
+			}
+
+			auto& state = states_.at(job.symbol);
+			state.latest.publish(std::move(snap));
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			--score_in_flight_;
+			state.pending = false;
+			state.failures = 0;
+			state.last_error.clear();
+			state.next_due = Clock::now() + state.refresh_interval;
+			++scans_completed_;
+		}
+		catch (const std::exception& e) {
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				--score_in_flight_;
+			}
+			markFailed(job.symbol, e.what());
+		}
+	}
+}
+
+void ScanScheduler::markFailed(const std::string& symbol, const std::string& error) {
+	std::cerr << "[C++] Scan of " << symbol << " failed: " << error << std::endl;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto& state = states_.at(symbol);
+	state.pending = false;
+	state.failures++;
+	state.last_error = error;
+	state.next_due = Clock::now() + state.refresh_interval;
+}
+
+crow::json::wvalue ScanScheduler::status() const {
+	crow::json::wvalue res;
+	auto now = Clock::now();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	res["enabled"] = running_;
+	res["universe"] = static_cast<long long>(states_.size());
+	res["refresh_interval_s"] = static_cast<long long>(config_.refresh_interval.count());
+	res["max_upstream"] = static_cast<long long>(config_.max_upstream);
+	res["workers"] = static_cast<long long>(config_.workers);
+	res["fetch_queue_depth"] = static_cast<long long>(fetch_queue_.size());
+	res["score_queue_depth"] = static_cast<long long>(score_queue_.size());
+	res["fetch_in_flight"] = static_cast<long long>(fetch_in_flight_);
+	res["score_in_flight"] = static_cast<long long>(score_in_flight_);
+	res["scans_completed"] = static_cast<long long>(scans_completed_.load());
+
+	long long max_age_ms = 0;
+	crow::json::wvalue symbols;
+	for (const auto& [sym, state] : states_) {
+		crow::json::wvalue s;
+
+		bool scored = state.latest.read([&](const ScanSnapshot& snap) {
+			long long age_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - snap.scored_at).count();
+			max_age_ms = std::max(max_age_ms, age_ms);
+			s["age_ms"] = age_ms;
+			s["stale"] = now - snap.scored_at > 2 * state.refresh_interval;
+			s["fetch_us"] = static_cast<long long>(snap.fetch_time.count());
+			s["score_us"] = static_cast<long long>(snap.score_time.count());
+		});
+		if (!scored) {
+			s["age_ms"] = -1;
+			s["stale"] = true;
+		}
+		s["refresh_interval_s"] = static_cast<long long>(state.refresh_interval.count());
+		s["pending"] = state.pending;
+		s["failures"] = static_cast<long long>(state.failures);
+		s["last_error"] = state.last_error;
+		symbols[sym] = std::move(s);
+	}
+	res["max_age_ms"] = max_age_ms;
+	res["symbols"] = std::move(symbols);
+	return res;
+}
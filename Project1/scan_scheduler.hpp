@@ -0,0 +1,173 @@
+#ifndef SCAN_SCHEDULER_HPP
+#define SCAN_SCHEDULER_HPP
+
+#include <crow.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class SessionRecorder;
+
+struct ScanConfig {
+	std::vector<std::string> symbols;
+	std::chrono::seconds refresh_interval{ 60 };                            // default for every symbol
+	std::unordered_map<std::string, std::chrono::seconds> intervals;        // per-symbol overrides
+	double r = 0.01;
+	size_t max_upstream = 4;   // concurrent calls to the Python API
+	size_t workers = 2;        // scoring threads
+};
+
+// Reads SCAN_SYMBOLS, SCAN_INTERVAL_S, SCAN_RATE, SCAN_MAX_UPSTREAM and
+// SCAN_WORKERS. SCAN_SYMBOLS is comma separated; "AAPL:30" refreshes AAPL
+// every 30 s instead of SCAN_INTERVAL_S. An empty universe disables the scanner.
+ScanConfig loadScanConfig();
+
+// Latest scored /price body for one symbol. Immutable once published.
+struct ScanSnapshot {
+	std::string body;
+	double r = 0.0;
+	std::chrono::steady_clock::time_point scored_at;
+	std::chrono::microseconds fetch_time{ 0 };
+	std::chrono::microseconds score_time{ 0 };
+};
+
+// Double-buffered snapshot holder with a single writer. The epoch selects the
+// live slot; readers pin it with that slot's counter and re-check the epoch,
+// which only costs lock-free atomic increments. The writer fills the idle
+// slot once its last readers have drained, then bumps the epoch, so a
+// snapshot is freed two publications after it was replaced.
+class SnapshotSlot {
+public:
+	SnapshotSlot() = default;
+	~SnapshotSlot();
+
+	SnapshotSlot(const SnapshotSlot&) = delete;
+	SnapshotSlot& operator=(const SnapshotSlot&) = delete;
+
+	// Calls f(const ScanSnapshot&) while the snapshot is pinned.
+	// Returns false if nothing was published yet.
+	template <class F>
+	bool read(F&& f) const {
+		while (true) {
+			const unsigned long long epoch = epoch_.load();
+			ReaderGuard guard(readers_[epoch & 1]);
+			if (epoch_.load() != epoch) continue;   // writer moved on, slot may be reused
+
+			const ScanSnapshot* snap = slots_[epoch & 1].load();
+			if (!snap) return false;
+			f(*snap);
+			return true;
+		}
+	}
+
+	// Single writer (the scheduler never scores a symbol twice concurrently).
+	void publish(std::unique_ptr<const ScanSnapshot> snap);
+
+private:
+	struct ReaderGuard {
+		std::atomic<unsigned>& count;
+		explicit ReaderGuard(std::atomic<unsigned>& c) : count(c) { count.fetch_add(1); }
+		~ReaderGuard() { count.fetch_sub(1); }
+	};
+
+	static_assert(std::atomic<const ScanSnapshot*>::is_always_lock_free, "snapshot pointer must be lock-free");
+	static_assert(std::atomic<unsigned long long>::is_always_lock_free, "epoch must be lock-free");
+
+	std::atomic<unsigned long long> epoch_{ 0 };
+	std::atomic<const ScanSnapshot*> slots_[2] = { nullptr, nullptr };
+	mutable std::atomic<unsigned> readers_[2] = { 0u, 0u };
+};
+
+// Background universe scanner: a timer enqueues symbols when their refresh is
+// due, `max_upstream` fetcher threads pull chains from the Python API and a
+// pool of `workers` threads rescores them. Each symbol's latest snapshot lives
+// in a SnapshotSlot, so readers never block on a rescore. With a recorder,
+// every scored snapshot is also appended to the session as a "scan" record.
+class ScanScheduler {
+public:
+	using FetchFn = std::function<nlohmann::json(const std::string&)>;
+
+	ScanScheduler(ScanConfig config, FetchFn fetch, SessionRecorder* recorder = nullptr);
+	~ScanScheduler();
+
+	ScanScheduler(const ScanScheduler&) = delete;
+	ScanScheduler& operator=(const ScanScheduler&) = delete;
+
+	void start();
+	void stop();
+
+	// Calls f(const ScanSnapshot&) with the symbol's latest snapshot. Returns
+	// false if the symbol is outside the universe or not scored yet.
+	template <class F>
+	bool readSnapshot(const std::string& symbol, F&& f) const {
+		auto it = states_.find(symbol);
+		return it != states_.end() && it->second.latest.read(std::forward<F>(f));
+	}
+
+	// Refresh interval of a symbol (the default one outside the universe).
+	std::chrono::seconds refreshInterval(const std::string& symbol) const {
+		auto it = states_.find(symbol);
+		return it != states_.end() ? it->second.refresh_interval : config_.refresh_interval;
+	}
+
+	// Snapshots older than this are reported stale and not served by /price.
+	std::chrono::steady_clock::duration staleAfter(const std::string& symbol) const { return 2 * refreshInterval(symbol); }
+
+	// Queue depths, in-flight counts and per-symbol staleness.
+	crow::json::wvalue status() const;
+
+	const ScanConfig& config() const { return config_; }
+
+private:
+	struct SymbolState {
+		SnapshotSlot latest;                           // lock-free, outside mutex_
+		std::chrono::seconds refresh_interval{ 0 };    // fixed at construction
+		std::chrono::steady_clock::time_point next_due{};
+		bool pending = false;                          // queued, fetching or scoring
+		unsigned failures = 0;
+		std::string last_error;
+	};
+
+	struct ScoreJob {
+		std::string symbol;
+		nlohmann::json chain;
+		std::chrono::microseconds fetch_time;
+	};
+
+	void timerLoop();
+	void fetchLoop();
+	void scoreLoop();
+	void markFailed(const std::string& symbol, const std::string& error);
+
+	ScanConfig config_;
+	FetchFn fetch_;
+	SessionRecorder* recorder_;
+
+	// Keys are fixed at construction, so lookups need no lock; only the
+	// bookkeeping fields of SymbolState are guarded by mutex_.
+	std::unordered_map<std::string, SymbolState> states_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable fetch_cv_;
+	std::condition_variable score_cv_;
+	std::condition_variable timer_cv_;
+	std::deque<std::string> fetch_queue_;
+	std::deque<ScoreJob> score_queue_;
+	size_t fetch_in_flight_ = 0;
+	size_t score_in_flight_ = 0;
+	bool running_ = false;
+
+	std::atomic<unsigned long long> scans_completed_{ 0 };
+	std::vector<std::thread> threads_;
+};
+
+#endif
@@ -0,0 +1,330 @@
+#include "scoring.hpp"
+#include "black_scholes.hpp"
+#include "bs_kernels.hpp"
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+// Jours depuis le 1970-01-01 (calendrier grégorien), sans fuseau horaire.
+static long long daysFromCivil(long long y, unsigned m, unsigned d) {
+	y -= m <= 2;
+	const long long era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned yoe = static_cast<unsigned>(y - era * 400);
+	const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+// "YYYY-MM-DD" -> minuit UTC, pour des maturités identiques quel que soit TZ.
+static bool parseDateUtc(const std::string& date_str, std::time_t& out) {
+	std::tm tm = {};
+	std::istringstream ss(date_str);
+	ss >> std::get_time(&tm, "%Y-%m-%d");
+	if (ss.fail()) return false;
+	out = static_cast<std::time_t>(daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * 86400);
+	return true;
+}
+
+double computeMaturity(const std::string& expiration_str, std::time_t now_time) {
+	std::time_t exp_time;
+	if (!parseDateUtc(expiration_str, exp_time)) return 0.0;
+	double T = std::difftime(exp_time, now_time) / (60 * 60 * 24 * 365.0);
+	return std::max(T, 0.0);
+}
+
+double computeMaturity_Test(const std::string& expiration_str, const std::string& date_str) {
+	std::time_t time_exp, time_date;
+	if (!parseDateUtc(expiration_str, time_exp) || !parseDateUtc(date_str, time_date)) {
+		return 0.0;
+	}
+
+	double T = std::difftime(time_exp, time_date) / (60.0 * 60 * 24 * 365.0);
+	return std::max(T, 0.0);
+}
+
+void scoreOptionChain(const nlohmann::json& data, double r, GroupedOptions& grouped,
+	std::time_t now, ScoreTimings* timings)
+{
+	using StageClock = std::chrono::steady_clock;
+	auto t_start = StageClock::now();
+
+	// =========================================================
+	// PHASE 1 : Calcul IV mean / std pour chaque symbole
+	// =========================================================
+	std::unordered_map<std::string, std::vector<double>> iv_by_symbol;
+
+	for (const auto& opt : data) {
+		std::string sym = opt.at("symbol").get<std::string>();
+		double sigma = opt.at("impliedVolatility").get<double>();
+		if (sigma > 0.0)
+			iv_by_symbol[sym].push_back(sigma);
+	}
+
+	struct IVStats { double mean; double std; };
+	std::unordered_map<std::string, IVStats> iv_surface;
+
+	for (auto& [sym, vols] : iv_by_symbol) {
+		double sum = 0.0;
+		for (double v : vols) sum += v;
+		double mean = sum / vols.size();
+
+		double sq = 0.0;
+		for (double v : vols) sq += (v - mean) * (v - mean);
+		double std = std::sqrt(sq / vols.size());
+		if (std < 0.0001) std = 0.0001;
+
+		iv_surface[sym] = { mean, std };
+	}
+
+	auto t_iv = StageClock::now();
+
+	// =========================================================
+	// PARAMÈTRES RÉALISTES
+	// =========================================================
+	const double MIN_VOLUME = 50;
+	const double MIN_DELTA = 0.02;
+	const double MAX_DELTA = 0.98;
+	const double MIN_PROB = 0.10;
+	const double MAX_PROB = 0.98;
+
+	// BUY / SELL réalistes
+	const double BUY_SCORE = 10;
+	const double SELL_SCORE = -10;
+
+
+	// =========================================================
+	// PHASE 2 : LECTURE + PARTITION CALL / PUT
+	// =========================================================
+	struct Contract {
+		std::string opt_type;
+		std::string sym;
+		std::string expiration;
+		double K, S, sigma, last_px, T, V;
+		bool is_call;
+	};
+
+	// Colonnes (SoA) par type, pour des kernels sans branche par contrat
+	struct Batch {
+		std::vector<size_t> index;
+		std::vector<double> S, K, sigma, T;
+		std::vector<GreekValues> greeks;
+
+		void push(size_t i, const Contract& c) {
+			index.push_back(i);
+			S.push_back(c.S);
+			K.push_back(c.K);
+			sigma.push_back(c.sigma);
+			T.push_back(c.T);
+		}
+	};
+
+	std::vector<Contract> contracts;
+	contracts.reserve(data.size());
+	Batch calls, puts;
+
+	for (const auto& opt : data) {
+		Contract c;
+		c.opt_type = opt.at("type").get<std::string>();
+		c.sym = opt.at("symbol").get<std::string>();
+
+		c.K = opt.at("strike").get<double>();
+		c.S = opt.at("spot").get<double>();
+		c.sigma = opt.at("impliedVolatility").get<double>();
+		c.last_px = opt.at("lastPrice").get<double>();
+		c.expiration = opt.at("expiration").get<std::string>();
+		c.T = computeMaturity(c.expiration, now);
+		c.V = opt.contains("volume") ? opt.at("volume").get<double>() : 100.0;
+		c.is_call = (c.opt_type == "call");
+
+		if (c.T <= 0 || c.sigma <= 0 || c.S <= 0) continue;
+		if (c.sigma < 0.01) continue;
+
+		(c.is_call ? calls : puts).push(contracts.size(), c);
+		contracts.push_back(std::move(c));
+	}
+
+	auto t_parse = StageClock::now();
+
+	// =========================================================
+	// PHASE 3 : BLACK-SCHOLES + GRECS (kernels spécialisés)
+	// =========================================================
+	std::vector<GreekValues> greeks(contracts.size());
+
+	calls.greeks.resize(calls.index.size());
+	bsKernelBatch<OptionType::Call, Greek::All>(calls.S.data(), calls.K.data(), calls.sigma.data(), calls.T.data(),
+		r, calls.index.size(), calls.greeks.data());
+	puts.greeks.resize(puts.index.size());
+	bsKernelBatch<OptionType::Put, Greek::All>(puts.S.data(), puts.K.data(), puts.sigma.data(), puts.T.data(),
+		r, puts.index.size(), puts.greeks.data());
+
+	for (const Batch* batch : { &calls, &puts })
+		for (size_t j = 0; j < batch->index.size(); ++j)
+			greeks[batch->index[j]] = batch->greeks[j];
+
+	auto t_kernels = StageClock::now();
+
+	// =========================================================
+	// PHASE 4 : SCORING (ordre d'origine de la chaîne)
+	// =========================================================
+
+	for (size_t i = 0; i < contracts.size(); ++i) {
+		const Contract& c = contracts[i];
+		const GreekValues& g = greeks[i];
+
+		const std::string& opt_type = c.opt_type;
+		const std::string& sym = c.sym;
+		const std::string& expiration = c.expiration;
+		const bool is_call = c.is_call;
+		const double K = c.K, S = c.S, sigma = c.sigma, last_px = c.last_px, T = c.T, V = c.V;
+
+		auto stats = iv_surface[sym];
+		double iv_mean = stats.mean;
+		double iv_std = stats.std;
+
+		double bs_price = g.price;
+		double delta = g.delta;
+		double gam = g.gamma;
+		double theta = g.theta;
+		double rho_val = g.rho;
+		double vega_val = g.vega;
+
+		double prob_ITM = g.prob_ITM;
+		double mispricing = bs_price - last_px;
+
+		double raw_score = mispricing * delta * V;
+		if (std::isnan(raw_score)) continue;
+
+		// -----------------------------------------------------
+		// MÉTRIQUES OPTIMISÉES
+		// -----------------------------------------------------
+		double vega_score = vegaNormalized(mispricing, vega_val);
+		double iv_z = ivZScore(sigma, iv_mean, iv_std);
+		double liq = liquidityScore(V, delta);
+		double gammaRisk = gammaRiskScore(gam, S, 0.02);
+
+		double skewVal = skewEdge(sigma, iv_mean, iv_std, S / K);
+		double smileDist = smileDistance(sigma, iv_mean);
+
+		double final_score = sabrEnhancedScore(
+			raw_score,
+			vega_score,
+			iv_z,
+			liq,
+			gammaRisk,
+			skewVal,
+			smileDist
+		);
+		// ====================
+		// BS VALIDITY FILTERS
+		// ====================
+		bool extremeITM = (is_call && S / K > 2.5)
+			|| (!is_call && K / S > 2.5);
+
+		bool shortMaturity = (T < 0.03);
+
+		bool inconsistentProb =
+			(is_call && S > 1.5 * K && prob_ITM < 0.70)
+			|| (!is_call && K > 1.5 * S && prob_ITM < 0.70);
+
+		// Cap BS price for ITM near-expiry
+		double intrinsic = std::max((is_call ? S - K : K - S), 0.0);
+		if (extremeITM && T < 0.10) {
+			bs_price = intrinsic + 2.0;
+			mispricing = bs_price - last_px;
+		}
+
+		// Stabilized theta
+		double theta_adj = -(last_px - intrinsic) / T;
+		if (extremeITM || shortMaturity)
+			theta = std::max(theta, theta_adj);
+		// -----------------------------------------------------
+		// RÈGLES DE TRADING
+		// -----------------------------------------------------
+		std::string action = "hold";
+		std::string reason = "Neutral";
+
+		bool bad_maturity = (T < 0.02);
+		bool bad_volume = (V < MIN_VOLUME);
+
+		double max_delta_allowed = dynamicMaxDelta(T, (S / K));
+		bool bad_delta = (std::abs(delta) < MIN_DELTA || std::abs(delta) > max_delta_allowed);
+
+		bool bad_prob = (prob_ITM < MIN_PROB || prob_ITM > MAX_PROB);
+
+		if (bad_maturity || bad_volume || bad_delta || bad_prob) {
+			action = "ignore";
+			reason = "Market structure filter";
+		}
+		else if (final_score > BUY_SCORE && vega_score > 0.05 && mispricing > 0 && ((iv_z < 0.15) || (delta > 0.75 && gammaRisk < 0.5))) {
+			action = "buy";
+			reason = "Strong ITM + positive edge despite elevated IV";
+		}
+		else if (mispricing < 0 && final_score < SELL_SCORE && vega_score < -0.05 && iv_z > 0) {
+			action = "sell";
+			reason = "Expensive IV + negative vega edge + good structure";
+		}
+
+		// -----------------------------------------------------
+		// JSON OUTPUT
+		// -----------------------------------------------------
+		crow::json::wvalue res;
+		res["type"] = opt_type;
+		res["strike"] = K;
+		res["spot"] = S;
+		res["expiration"] = expiration;
+		res["maturity"] = T;
+		res["sigma"] = sigma;
+
+		res["bs_price"] = bs_price;
+		res["market_price"] = last_px;
+
+		res["delta"] = delta;
+		res["gamma"] = gam;
+		res["theta"] = theta;
+		res["vega"] = vega_val;
+		res["rho"] = rho_val;
+
+		res["volume"] = V;
+		res["mispricing"] = mispricing;
+		res["prob_ITM"] = prob_ITM;
+		res["moneyness"] = S / K;
+
+		res["iv_mean"] = iv_mean;
+		res["iv_std"] = iv_std;
+		res["iv_z"] = iv_z;
+
+		res["vega_score"] = vega_score;
+		res["liquidity"] = liq;
+		res["gamma_risk"] = gammaRisk;
+
+		res["final_score"] = final_score;
+		res["action"] = action;
+		res["action_reason"] = reason;
+
+		grouped[sym].push_back(std::move(res));
+	}
+
+	if (timings) {
+		auto t_end = StageClock::now();
+		timings->iv_surface = t_iv - t_start;
+		timings->parse = t_parse - t_iv;
+		timings->kernels = t_kernels - t_parse;
+		timings->scoring = t_end - t_kernels;
+	}
+}
+
+crow::json::wvalue buildPriceResponse(const std::string& symbol, GroupedOptions& grouped)
+{
+	crow::json::wvalue results;
+	results["symbol"] = symbol;
+
+	crow::json::wvalue options_by_symbol;
+	for (auto& [sym, vec] : grouped)
+		options_by_symbol[sym] = std::move(vec);
+
+	results["options"] = std::move(options_by_symbol);
+	return results;
+}
@@ -0,0 +1,35 @@
+#ifndef SCORING_HPP
+#define SCORING_HPP
+
+#include <crow.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+// Scored contracts grouped by underlying symbol, as serialized under "options".
+using GroupedOptions = std::map<std::string, std::vector<crow::json::wvalue>>;
+
+// Duration of each stage of scoreOptionChain.
+struct ScoreTimings {
+	std::chrono::nanoseconds iv_surface{ 0 };
+	std::chrono::nanoseconds parse{ 0 };
+	std::chrono::nanoseconds kernels{ 0 };
+	std::chrono::nanoseconds scoring{ 0 };
+};
+
+// Expirations are read as midnight UTC, so results do not depend on TZ.
+double computeMaturity(const std::string& expiration_str, std::time_t now);
+double computeMaturity_Test(const std::string& expiration_str, const std::string& date_str);
+
+// Full /price pipeline (IV surface, Black-Scholes + greeks, scoring, trading rules)
+// applied to one upstream option chain. Results are appended to `grouped`.
+// Maturities are measured from `now`.
+void scoreOptionChain(const nlohmann::json& data, double r, GroupedOptions& grouped,
+	std::time_t now, ScoreTimings* timings = nullptr);
+
+crow::json::wvalue buildPriceResponse(const std::string& symbol, GroupedOptions& grouped);
+
+#endif
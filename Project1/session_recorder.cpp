@@ -0,0 +1,79 @@
+#include "session_recorder.hpp"
+#include <stdexcept>
+
+SessionRecorder::SessionRecorder(const std::string& path)
+	: path_(path), out_(path, std::ios::binary | std::ios::app)
+{
+	if (!out_.is_open())
+		throw std::runtime_error("Unable to open session file " + path);
+}
+
+std::uint64_t fnv1a64(const std::string& s) {
+	std::uint64_t h = 1469598103934665603ULL;
+	for (unsigned char c : s) {
+		h ^= c;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+void SessionRecorder::record(const RecordedQuery& query) {
+	nlohmann::json rec;
+	rec["ts_ms"] = query.ts_ms;
+	rec["source"] = query.source;
+	rec["query"] = query.query;
+	rec["r"] = query.r;
+	rec["chains"] = nlohmann::json::array();
+	for (const auto& chain : query.chains)
+		rec["chains"].push_back({ {"symbol", chain.symbol}, {"payload", chain.payload}, {"fetch_us", chain.fetch_us} });
+	rec["body_hash"] = query.body_hash;
+	std::vector<std::uint8_t> bytes = nlohmann::json::to_cbor(rec);
+
+	std::uint32_t len = static_cast<std::uint32_t>(bytes.size());
+	char header[4] = {
+		static_cast<char>(len & 0xff),
+		static_cast<char>((len >> 8) & 0xff),
+		static_cast<char>((len >> 16) & 0xff),
+		static_cast<char>((len >> 24) & 0xff),
+	};
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	out_.write(header, sizeof(header));
+	out_.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	out_.flush();
+}
+
+bool readRecordBytes(std::istream& in, std::vector<std::uint8_t>& bytes) {
+	unsigned char header[4];
+	in.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (in.gcount() == 0)
+		return false;
+	if (in.gcount() != sizeof(header))
+		throw std::runtime_error("Truncated session record header");
+
+	std::uint32_t len = header[0]
+		| (static_cast<std::uint32_t>(header[1]) << 8)
+		| (static_cast<std::uint32_t>(header[2]) << 16)
+		| (static_cast<std::uint32_t>(header[3]) << 24);
+
+	bytes.resize(len);
+	in.read(reinterpret_cast<char*>(bytes.data()), len);
+	if (static_cast<std::uint32_t>(in.gcount()) != len)
+		throw std::runtime_error("Truncated session record");
+	return true;
+}
+
+RecordedQuery decodeRecord(const std::vector<std::uint8_t>& bytes) {
+	nlohmann::json rec = nlohmann::json::from_cbor(bytes);
+
+	RecordedQuery query;
+	query.ts_ms = rec.at("ts_ms").get<long long>();
+	query.source = rec.at("source").get<std::string>();
+	query.query = rec.at("query").get<std::string>();
+	query.r = rec.at("r").get<double>();
+	for (auto& chain : rec.at("chains"))
+		query.chains.push_back({ chain.at("symbol").get<std::string>(), std::move(chain.at("payload")),
+			chain.value("fetch_us", 0LL) });
+	query.body_hash = rec.at("body_hash").get<std::uint64_t>();
+	return query;
+}
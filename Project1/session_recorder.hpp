@@ -0,0 +1,56 @@
+#ifndef SESSION_RECORDER_HPP
+#define SESSION_RECORDER_HPP
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One upstream chain as it arrived for a query.
+struct RecordedChain {
+	std::string symbol;
+	nlohmann::json payload;
+	long long fetch_us = 0;              // from the start of the query (price) or of the fetch (scan) to arrival
+};
+
+// Everything needed to rebuild one scored /price body: the inputs of
+// scoreOptionChain (chains in scoring order, r, clock) and the hash of the
+// body that was actually served.
+struct RecordedQuery {
+	long long ts_ms = 0;                 // scoring clock, ms since epoch (maturities use ts_ms / 1000)
+	std::string source;                  // "price" (live /price) or "scan" (scanner snapshot)
+	std::string query;                   // symbol parameter, as passed to buildPriceResponse
+	double r = 0.0;
+	std::vector<RecordedChain> chains;   // in arrival order
+	std::uint64_t body_hash = 0;         // fnv1a64 of the served body
+};
+
+// FNV-1a 64-bit, used to compare served and replayed bodies.
+std::uint64_t fnv1a64(const std::string& s);
+
+// Append-only session file. Each record is a 4-byte little-endian length
+// followed by the CBOR encoding of {"ts_ms", "source", "query", "r",
+// "chains": [{"symbol", "payload", "fetch_us"}], "body_hash"}.
+class SessionRecorder {
+public:
+	explicit SessionRecorder(const std::string& path);
+
+	void record(const RecordedQuery& query);
+
+	const std::string& path() const { return path_; }
+
+private:
+	std::string path_;
+	std::mutex mutex_;
+	std::ofstream out_;
+};
+
+// Next raw record of a session file; false at end of file.
+// Throws on a truncated record.
+bool readRecordBytes(std::istream& in, std::vector<std::uint8_t>& bytes);
+RecordedQuery decodeRecord(const std::vector<std::uint8_t>& bytes);
+
+#endif
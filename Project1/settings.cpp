@@ -0,0 +1,58 @@
+#include "settings.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+std::optional<std::string> readSetting(const std::string& name, const std::string& path) {
+	if (const char* value = std::getenv(name.c_str()))
+		return std::string(value);
+
+	std::ifstream file(path);
+	std::string line;
+	const std::string prefix = name + "=";
+
+	while (std::getline(file, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.rfind(prefix, 0) == 0)
+			return line.substr(prefix.size());
+	}
+	return std::nullopt;
+}
+
+double readSettingDouble(const std::string& name, double fallback) {
+	auto value = readSetting(name);
+	if (!value || value->empty()) return fallback;
+	try {
+		return std::stod(*value);
+	}
+	catch (const std::exception&) {
+		return fallback;
+	}
+}
+
+long readSettingInt(const std::string& name, long fallback) {
+	auto value = readSetting(name);
+	if (!value || value->empty()) return fallback;
+	try {
+		return std::stol(*value);
+	}
+	catch (const std::exception&) {
+		return fallback;
+	}
+}
+
+std::vector<std::string> splitList(const std::string& value, char sep) {
+	std::vector<std::string> items;
+	std::stringstream ss(value);
+	std::string item;
+
+	while (std::getline(ss, item, sep)) {
+		item.erase(std::remove_if(item.begin(), item.end(), [](unsigned char c) { return std::isspace(c); }), item.end());
+		if (!item.empty() && std::find(items.begin(), items.end(), item) == items.end())
+			items.push_back(item);
+	}
+	return items;
+}
@@ -0,0 +1,18 @@
+#ifndef SETTINGS_HPP
+#define SETTINGS_HPP
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// Looks up NAME in the process environment first, then NAME=value in the .env
+// file (same precedence as python-dotenv on the FastAPI side).
+std::optional<std::string> readSetting(const std::string& name, const std::string& path = ".env");
+
+double readSettingDouble(const std::string& name, double fallback);
+long readSettingInt(const std::string& name, long fallback);
+
+// "AAPL, MSFT,,AAPL" -> { "AAPL", "MSFT" }: trimmed, without empties or duplicates.
+std::vector<std::string> splitList(const std::string& value, char sep = ',');
+
+#endif
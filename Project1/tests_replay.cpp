@@ -0,0 +1,102 @@
+// Record / replay round trip (POSIX only): api_cpp records live /price
+// queries served from a local mock_upstream, then replay must rebuild the
+// same bodies, in the recording time zone and in two others. Run by ctest
+// with the three binaries as arguments.
+//
+//   tests_replay ./mock_upstream ./api_cpp ./replay
+
+#include "process_util.hpp"
+#include <cpr/cpr.h>
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << what << std::endl;
+	if (!ok) ++failures;
+}
+
+#ifndef _WIN32
+static void testRoundTrip(const std::string& mock_binary, const std::string& api_binary, const std::string& replay_binary) {
+	const std::string mock_url = "http://localhost:18121";
+	const std::string api_url = "http://localhost:18122";
+	const std::string session = "tests_replay_session.bin";
+	const std::string report_path = "tests_replay_report.json";
+	std::remove(session.c_str());
+
+	pid_t mock = spawnProcess({ mock_binary, "--port", "18121", "--threads", "4",
+		"--expirations", "3", "--strikes", "5" });
+	if (!waitForHttp(mock_url + "/stats")) {
+		terminateProcess(mock);
+		throw std::runtime_error("mock_upstream did not start on " + mock_url);
+	}
+
+	pid_t api = spawnProcess({ api_binary }, {
+		{ "SERVER_PORT", "18122" },
+		{ "SERVER_THREADS", "2" },
+		{ "UPSTREAM_URL", mock_url },
+		{ "API_KEY", "test" },
+		{ "SCAN_SYMBOLS", "" },
+		{ "SESSION_RECORD_FILE", session },
+		{ "TZ", "UTC" },
+	});
+	if (!waitForHttp(api_url + "/scan/status")) {
+		terminateProcess(api);
+		terminateProcess(mock);
+		throw std::runtime_error("api_cpp did not start on " + api_url);
+	}
+
+	auto single = cpr::Get(cpr::Url{ api_url + "/price" }, cpr::Parameters{ { "symbol", "AAPL" }, { "r", "0.03" } });
+	auto multi = cpr::Get(cpr::Url{ api_url + "/price" }, cpr::Parameters{ { "symbol", "AAPL,MSFT" }, { "r", "0.01" } });
+	terminateProcess(api);
+	terminateProcess(mock);
+
+	check(single.status_code == 200 && nlohmann::json::parse(single.text)["symbol"] == "AAPL", "/price serves one symbol");
+	check(multi.status_code == 200 && nlohmann::json::parse(multi.text)["symbol"] == "AAPL,MSFT", "/price serves two symbols");
+
+	// Recorded in UTC; maturities must not move with the replay time zone
+	for (const char* tz : { "UTC", "America/New_York", "Asia/Tokyo" }) {
+		std::remove(report_path.c_str());
+		pid_t replay = spawnProcess({ replay_binary, "--session", session, "--repeat", "2", "--report", report_path },
+			{ { "TZ", tz } });
+		check(waitProcess(replay) == 0, std::string("replay rebuilds the served bodies (TZ=") + tz + ")");
+	}
+
+	std::ifstream in(report_path);
+	nlohmann::json report = nlohmann::json::parse(in, nullptr, false);
+	check(!report.is_discarded() && report["records"] == 2 && report["hash_mismatches"] == 0, "replay report counts both records");
+	check(!report.is_discarded() && report["recorded_upstream"]["chain"]["count"] == 3
+		&& report["recorded_upstream"]["query"]["max_us"].get<double>() > 0,
+		"replay reports the recorded upstream latency of every chain");
+
+	std::remove(session.c_str());
+	std::remove(report_path.c_str());
+}
+#endif
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+	std::cout << "tests_replay: POSIX only, skipped" << std::endl;
+	return 0;
+#else
+	if (argc < 4) {
+		std::cerr << "usage: tests_replay MOCK_UPSTREAM_BINARY API_CPP_BINARY REPLAY_BINARY" << std::endl;
+		return 2;
+	}
+
+	try {
+		testRoundTrip(argv[1], argv[2], argv[3]);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "tests_replay: " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+	return failures ? 1 : 0;
+#endif
+}
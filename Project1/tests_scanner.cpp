@@ -0,0 +1,192 @@
+// SnapshotSlot publish/read stress test, then one ScanScheduler cycle against
+// a local mock_upstream (POSIX only): fresh snapshots, the failure path,
+// status() counts, per-symbol intervals and staleness once the upstream is
+// gone. Run by ctest with the mock_upstream binary as argument.
+//
+//   tests_scanner ./mock_upstream
+
+#include "scan_scheduler.hpp"
+#include "upstream_client.hpp"
+#include "process_util.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using TestClock = std::chrono::steady_clock;
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << what << std::endl;
+	if (!ok) ++failures;
+}
+
+// Readers must always see a whole snapshot (body matching r) and never go
+// back in time, while the writer keeps replacing and freeing snapshots.
+static void testSnapshotSlot() {
+	const int publishes = 20000;
+	const int readers = 4;
+
+	SnapshotSlot slot;
+	check(!slot.read([](const ScanSnapshot&) {}), "empty slot reads nothing");
+
+	std::atomic<bool> done{ false };
+	std::atomic<long long> reads{ 0 };
+	std::atomic<long long> torn{ 0 };
+	std::atomic<long long> backwards{ 0 };
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < readers; ++t) {
+		threads.emplace_back([&] {
+			double last = -1.0;
+			while (!done.load()) {
+				slot.read([&](const ScanSnapshot& snap) {
+					if (snap.body != std::to_string(static_cast<long long>(snap.r))) ++torn;
+					if (snap.r < last) ++backwards;
+					last = snap.r;
+					++reads;
+				});
+			}
+		});
+	}
+
+	// Publish a first snapshot and wait until the readers are reading it, so
+	// the writer cannot finish before they are scheduled.
+	auto first = std::make_unique<ScanSnapshot>();
+	first->r = 0;
+	first->body = "0";
+	slot.publish(std::move(first));
+	while (reads.load() < readers)
+		std::this_thread::yield();
+
+	auto start = TestClock::now();
+	for (int i = 1; i < publishes; ++i) {
+		auto snap = std::make_unique<ScanSnapshot>();
+		snap->r = i;
+		snap->body = std::to_string(i);
+		slot.publish(std::move(snap));
+	}
+	auto elapsed = TestClock::now() - start;
+	done = true;
+	for (auto& t : threads)
+		t.join();
+
+	double last = -1.0;
+	slot.read([&](const ScanSnapshot& snap) { last = snap.r; });
+
+	check(reads.load() > 0, "readers made progress (" + std::to_string(reads.load()) + " reads)");
+	check(torn.load() == 0, "no torn snapshot");
+	check(backwards.load() == 0, "readers never see an older snapshot");
+	check(last == publishes - 1, "last publish is visible");
+	check(elapsed < std::chrono::seconds(20), "writer is not starved by readers");
+}
+
+#ifndef _WIN32
+static nlohmann::json statusJson(const ScanScheduler& scanner) {
+	return nlohmann::json::parse(scanner.status().dump());
+}
+
+// Polls `pred` every 50 ms for up to `limit`.
+template <class F>
+static bool waitFor(F&& pred, std::chrono::milliseconds limit) {
+	auto until = TestClock::now() + limit;
+	while (TestClock::now() < until) {
+		if (pred()) return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+	return pred();
+}
+
+static void testSchedulerCycle(const std::string& binary) {
+	const int port = 18111;
+	const std::string url = "http://localhost:" + std::to_string(port);
+	pid_t mock = spawnProcess({ binary, "--port", std::to_string(port), "--threads", "4",
+		"--expirations", "2", "--strikes", "3", "--missing", "BAD" });
+	if (!waitForHttp(url + "/stats")) {
+		terminateProcess(mock);
+		throw std::runtime_error("mock_upstream did not start on " + url);
+	}
+
+	UpstreamConfig upstream_config;
+	upstream_config.base_url = url;
+	upstream_config.api_key = "test";
+	upstream_config.pool_size = 2;
+	upstream_config.timeout = std::chrono::milliseconds(2000);
+	upstream_config.max_retries = 0;
+	UpstreamClient upstream(upstream_config);
+
+	ScanConfig config;
+	config.symbols = { "AAPL", "MSFT", "BAD" };
+	config.refresh_interval = std::chrono::seconds(1);
+	config.intervals["MSFT"] = std::chrono::seconds(5);
+	config.r = 0.02;
+	config.max_upstream = 2;
+	config.workers = 1;
+
+	ScanScheduler scanner(config, [&upstream](const std::string& sym) { return upstream.fetchChain(sym); });
+	check(scanner.staleAfter("AAPL") == std::chrono::seconds(2), "default interval applies");
+	check(scanner.staleAfter("MSFT") == std::chrono::seconds(10), "per-symbol interval applies");
+
+	scanner.start();
+	bool cycled = waitFor([&] {
+		auto status = statusJson(scanner);
+		return status["symbols"]["BAD"]["failures"].get<long long>() >= 2
+			&& status["scans_completed"].get<long long>() >= 3;
+	}, std::chrono::milliseconds(8000));
+	check(cycled, "scanner rescans on its interval and retries failed symbols");
+
+	auto status = statusJson(scanner);
+	check(status["enabled"].get<bool>(), "status reports the scanner enabled");
+	check(status["universe"].get<long long>() == 3, "status counts the universe");
+	check(status["symbols"]["MSFT"]["refresh_interval_s"].get<long long>() == 5, "status reports per-symbol intervals");
+	check(!status["symbols"]["AAPL"]["stale"].get<bool>(), "scored symbol is fresh");
+	check(status["symbols"]["BAD"]["stale"].get<bool>(), "never scored symbol is stale");
+	check(status["symbols"]["BAD"]["last_error"].get<std::string>().find("404") != std::string::npos,
+		"failure keeps the upstream error");
+
+	bool served = scanner.readSnapshot("AAPL", [&](const ScanSnapshot& snap) {
+		auto body = nlohmann::json::parse(snap.body);
+		check(snap.r == 0.02 && body["symbol"] == "AAPL" && !body["options"]["AAPL"].empty(), "snapshot holds the scored chain");
+	});
+	check(served, "scored symbol has a snapshot");
+	check(!scanner.readSnapshot("BAD", [](const ScanSnapshot&) {}), "failed symbol has no snapshot");
+	check(!scanner.readSnapshot("NVDA", [](const ScanSnapshot&) {}), "symbol outside the universe has no snapshot");
+
+	// Upstream gone: AAPL keeps its last snapshot but turns stale after 2 intervals
+	terminateProcess(mock);
+	bool stale = waitFor([&] { return statusJson(scanner)["symbols"]["AAPL"]["stale"].get<bool>(); },
+		std::chrono::milliseconds(6000));
+	check(stale, "snapshot turns stale when the upstream keeps failing");
+
+	auto stop_start = TestClock::now();
+	scanner.stop();
+	check(TestClock::now() - stop_start < std::chrono::seconds(5), "stop() returns");
+	check(!statusJson(scanner)["enabled"].get<bool>(), "status reports the scanner stopped");
+}
+#endif
+
+int main(int argc, char** argv) {
+	try {
+		testSnapshotSlot();
+#ifndef _WIN32
+		if (argc < 2) {
+			std::cerr << "usage: tests_scanner MOCK_UPSTREAM_BINARY" << std::endl;
+			return 2;
+		}
+		testSchedulerCycle(argv[1]);
+#else
+		(void)argc;
+		(void)argv;
+#endif
+	}
+	catch (const std::exception& e) {
+		std::cerr << "tests_scanner: " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+	return failures ? 1 : 0;
+}
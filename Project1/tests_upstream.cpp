@@ -0,0 +1,195 @@
+// UpstreamClient against a local mock_upstream (POSIX only): retry/backoff on
+// 5xx, request timeouts not retried, non-blocking fan-out (arrival order,
+// error propagation) and symbol encoding. Run by ctest with the mock_upstream
+// binary as argument.
+//
+//   tests_upstream ./mock_upstream
+
+#include "upstream_client.hpp"
+#include "process_util.hpp"
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using TestClock = std::chrono::steady_clock;
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << what << std::endl;
+	if (!ok) ++failures;
+}
+
+#ifndef _WIN32
+// One mock_upstream process for the lifetime of a test case.
+class MockServer {
+public:
+	MockServer(const std::string& binary, int port, std::vector<std::string> flags)
+		: url_("http://localhost:" + std::to_string(port))
+	{
+		std::vector<std::string> args = { binary, "--port", std::to_string(port), "--threads", "8",
+			"--expirations", "2", "--strikes", "3" };
+		args.insert(args.end(), flags.begin(), flags.end());
+		pid_ = spawnProcess(args);
+		if (!waitForHttp(url_ + "/stats")) {
+			terminateProcess(pid_);
+			throw std::runtime_error("mock_upstream did not start on " + url_);
+		}
+	}
+	~MockServer() { terminateProcess(pid_); }
+
+	const std::string& url() const { return url_; }
+
+	long long requests() const {
+		auto res = cpr::Get(cpr::Url{ url_ + "/stats" });
+		return nlohmann::json::parse(res.text)["requests"].get<long long>();
+	}
+
+private:
+	std::string url_;
+	pid_t pid_;
+};
+
+static UpstreamConfig testConfig(const MockServer& mock) {
+	UpstreamConfig config;
+	config.base_url = mock.url();
+	config.api_key = "test";
+	config.pool_size = 4;
+	config.max_retries = 2;
+	config.backoff = std::chrono::milliseconds(50);
+	return config;
+}
+
+static void testRetryBackoff(const std::string& binary) {
+	MockServer mock(binary, 18101, { "--fail-rate", "1.0" });
+	UpstreamClient client(testConfig(mock));
+
+	auto start = TestClock::now();
+	bool threw = false;
+	try {
+		client.fetchChain("AAPL");
+	}
+	catch (const std::exception& e) {
+		threw = std::string(e.what()).find("after 3 attempts") != std::string::npos;
+	}
+	auto elapsed = TestClock::now() - start;
+
+	check(threw, "503 gives up after max_retries + 1 attempts");
+	check(mock.requests() == 3, "503 is retried twice");
+	check(elapsed >= std::chrono::milliseconds(150), "backoff doubles between attempts (50 + 100 ms)");
+}
+
+static void testTimeoutNotRetried(const std::string& binary) {
+	MockServer mock(binary, 18102, { "--latency-ms", "600" });
+	UpstreamConfig config = testConfig(mock);
+	config.timeout = std::chrono::milliseconds(150);
+	UpstreamClient client(config);
+
+	auto start = TestClock::now();
+	bool threw = false;
+	try {
+		client.fetchChain("AAPL");
+	}
+	catch (const std::exception&) {
+		threw = true;
+	}
+	auto elapsed = TestClock::now() - start;
+
+	check(threw, "request timeout is reported");
+	check(elapsed < std::chrono::milliseconds(500), "request timeout fails fast");
+	check(mock.requests() == 1, "request timeout is not retried");
+}
+
+// Outcome of one fetchEachAsync call, times measured from the call.
+struct FanOutResult {
+	std::vector<std::pair<std::string, TestClock::duration>> chains;   // onChain calls, in order
+	std::string error;                                                  // what() of the failure
+	TestClock::duration returned{};                                     // fetchEachAsync returned
+	TestClock::duration done{};                                         // onDone ran
+};
+
+static FanOutResult runFanOut(UpstreamClient& client, const std::vector<std::string>& symbols) {
+	FanOutResult result;
+	std::promise<void> finished;
+	auto start = TestClock::now();
+
+	client.fetchEachAsync(symbols,
+		[&](const std::string& symbol, nlohmann::json chain) {
+			if (!chain.empty() && chain[0]["symbol"] == symbol)
+				result.chains.emplace_back(symbol, TestClock::now() - start);
+		},
+		[&](std::exception_ptr error) {
+			result.done = TestClock::now() - start;
+			if (error) {
+				try {
+					std::rethrow_exception(error);
+				}
+				catch (const std::exception& e) {
+					result.error = e.what();
+				}
+			}
+			finished.set_value();
+		});
+	result.returned = TestClock::now() - start;
+
+	finished.get_future().wait();
+	return result;
+}
+
+static void testFanOut(const std::string& binary) {
+	using std::chrono::milliseconds;
+	MockServer mock(binary, 18103, { "--latency-ms", "300", "--missing", "BAD",
+		"--symbol-latency-ms", "FAST:50,SLOW:600" });
+	UpstreamClient client(testConfig(mock));
+
+	auto all = runFanOut(client, { "AAPL", "MSFT", "NVDA" });
+	check(all.chains.size() == 3 && all.error.empty(), "fetchEachAsync delivers every chain");
+
+	// The missing symbol answers 404 at once, the others after 300 ms
+	auto failed = runFanOut(client, { "AAPL", "BAD", "MSFT" });
+	check(failed.error.find("404") != std::string::npos, "fetchEachAsync reports a failed symbol");
+	check(failed.chains.empty(), "no chain is delivered after the first failure");
+	check(failed.done >= milliseconds(300), "onDone waits for the slow requests before reporting the failure");
+
+	// FAST arrives after 50 ms, SLOW after 600 ms
+	auto staggered = runFanOut(client, { "SLOW", "FAST" });
+	check(staggered.returned < milliseconds(50), "fetchEachAsync does not block the caller");
+	check(staggered.chains.size() == 2 && staggered.chains[0].first == "FAST",
+		"chains are delivered in arrival order");
+	check(!staggered.chains.empty() && staggered.chains[0].second < milliseconds(400),
+		"the first chain is handed over before the last one arrives");
+	check(staggered.done >= milliseconds(600), "onDone runs after the last chain");
+
+	// Unencoded, '&' would end the symbol parameter and fetch "BRK" instead.
+	auto chain = client.fetchChain("BRK&B");
+	check(!chain.empty() && chain[0]["symbol"] == "BRK&B", "symbol is URL-encoded");
+}
+#endif
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+	std::cout << "tests_upstream: POSIX only, skipped" << std::endl;
+	return 0;
+#else
+	if (argc < 2) {
+		std::cerr << "usage: tests_upstream MOCK_UPSTREAM_BINARY" << std::endl;
+		return 2;
+	}
+	const std::string binary = argv[1];
+
+	try {
+		testRetryBackoff(binary);
+		testTimeoutNotRetried(binary);
+		testFanOut(binary);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "tests_upstream: " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+	return failures ? 1 : 0;
+#endif
+}
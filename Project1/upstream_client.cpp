@@ -0,0 +1,205 @@
+#include "upstream_client.hpp"
+#include "settings.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+UpstreamConfig loadUpstreamConfig(size_t default_pool) {
+	UpstreamConfig config;
+
+	auto key = readSetting("API_KEY");
+	if (!key || key->empty())
+		throw std::runtime_error("API_KEY not found (neither .env nor environment variable)");
+	config.api_key = *key;
+
+	if (auto url = readSetting("UPSTREAM_URL"); url && !url->empty()) {
+		config.base_url = *url;
+		while (!config.base_url.empty() && config.base_url.back() == '/')
+			config.base_url.pop_back();
+	}
+
+	config.pool_size = static_cast<size_t>(std::max(1L, readSettingInt("UPSTREAM_POOL", static_cast<long>(default_pool))));
+	config.timeout = std::chrono::milliseconds(std::max(1L, readSettingInt("UPSTREAM_TIMEOUT_MS", 60000)));
+	config.connect_timeout = std::chrono::milliseconds(std::max(1L, readSettingInt("UPSTREAM_CONNECT_TIMEOUT_MS", 1000)));
+	config.max_retries = static_cast<int>(std::max(0L, readSettingInt("UPSTREAM_RETRIES", 2)));
+	config.backoff = std::chrono::milliseconds(std::max(0L, readSettingInt("UPSTREAM_BACKOFF_MS", 200)));
+
+	std::cout << "[C++] Upstream " << config.base_url << " (pool " << config.pool_size
+		<< ", timeout " << config.timeout.count() << "ms, retries " << config.max_retries << ")" << std::endl;
+	return config;
+}
+
+UpstreamClient::UpstreamClient(UpstreamConfig config)
+	: config_(std::move(config))
+{
+	for (size_t i = 0; i < config_.pool_size; ++i)
+		threads_.emplace_back(&UpstreamClient::ioLoop, this);
+}
+
+UpstreamClient::~UpstreamClient() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		running_ = false;
+	}
+	cv_.notify_all();
+	for (auto& t : threads_)
+		t.join();
+
+	for (auto& batch : ready_)
+		for (auto& job : batch->jobs)
+			job.complete(std::make_exception_ptr(std::runtime_error("Upstream client shut down")), nullptr);
+}
+
+void UpstreamClient::submit(std::shared_ptr<Batch> batch) {
+	if (batch->jobs.empty()) return;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		ready_.push_back(std::move(batch));
+	}
+	cv_.notify_all();
+}
+
+std::future<nlohmann::json> UpstreamClient::fetchChainAsync(const std::string& symbol) {
+	auto promise = std::make_shared<std::promise<nlohmann::json>>();
+	auto future = promise->get_future();
+
+	auto batch = std::make_shared<Batch>();
+	batch->jobs.push_back(Job{ symbol, [promise](std::exception_ptr error, nlohmann::json chain) {
+		if (error)
+			promise->set_exception(error);
+		else
+			promise->set_value(std::move(chain));
+	} });
+	submit(std::move(batch));
+	return future;
+}
+
+nlohmann::json UpstreamClient::fetchChain(const std::string& symbol) {
+	return fetchChainAsync(symbol).get();
+}
+
+void UpstreamClient::fetchEachAsync(const std::vector<std::string>& symbols, ChainCallback onChain, DoneCallback onDone) {
+	if (symbols.empty()) {
+		onDone(nullptr);
+		return;
+	}
+
+	// Shared by the jobs of one fan-out; the last one to complete calls onDone.
+	struct FanOut {
+		std::mutex mutex;
+		size_t remaining = 0;
+		std::exception_ptr first_error;
+		ChainCallback on_chain;
+		DoneCallback on_done;
+	};
+	auto fan = std::make_shared<FanOut>();
+	fan->remaining = symbols.size();
+	fan->on_chain = std::move(onChain);
+	fan->on_done = std::move(onDone);
+
+	// A single batch: the whole query takes one turn in the round-robin.
+	auto batch = std::make_shared<Batch>();
+	for (const auto& symbol : symbols) {
+		batch->jobs.push_back(Job{ symbol, [fan, symbol](std::exception_ptr error, nlohmann::json chain) {
+			bool last;
+			{
+				std::lock_guard<std::mutex> lock(fan->mutex);
+				if (!error && !fan->first_error) {
+					try {
+						fan->on_chain(symbol, std::move(chain));
+					}
+					catch (...) {
+						error = std::current_exception();
+					}
+				}
+				if (error && !fan->first_error)
+					fan->first_error = error;
+				last = --fan->remaining == 0;
+			}
+			if (last)
+				fan->on_done(fan->first_error);
+		} });
+	}
+	submit(std::move(batch));
+}
+
+nlohmann::json UpstreamClient::perform(cpr::Session& session, const std::string& symbol) {
+	session.SetParameters(cpr::Parameters{ {"symbol", symbol} });
+
+	auto wait = config_.backoff;
+	for (int attempt = 0;; ++attempt) {
+		auto response = session.Get();
+
+		// Only failures where the Python side did no work (or asked us to back
+		// off) are retried. A timeout means the fetch may still be running
+		// upstream, so it is reported as is.
+		bool retryable;
+		if (response.error) {
+			retryable = response.error.code == cpr::ErrorCode::COULDNT_CONNECT
+				|| response.error.code == cpr::ErrorCode::COULDNT_RESOLVE_HOST;
+			if (!retryable)
+				throw std::runtime_error("API request failed for " + symbol + ": " + response.error.message);
+		}
+		else {
+			retryable = response.status_code == 429 || response.status_code >= 500;
+		}
+
+		if (!retryable) {
+			if (response.status_code == 403)
+				throw std::runtime_error("API key rejected (403 Forbidden). Check API_KEY value.");
+			if (response.status_code != 200)
+				throw std::runtime_error(
+					"API error (" + std::to_string(response.status_code) +
+					"): " + response.text
+				);
+			return nlohmann::json::parse(response.text);
+		}
+
+		if (attempt >= config_.max_retries) {
+			throw std::runtime_error(
+				"API unavailable for " + symbol + " after " + std::to_string(attempt + 1) + " attempts: " +
+				(response.error ? response.error.message : "HTTP " + std::to_string(response.status_code))
+			);
+		}
+
+		std::cerr << "[C++] Upstream retry " << (attempt + 1) << " for " << symbol << std::endl;
+		std::this_thread::sleep_for(wait);
+		wait *= 2;
+	}
+}
+
+void UpstreamClient::ioLoop() {
+	cpr::Session session;
+	session.SetUrl(cpr::Url{ config_.base_url + "/ticker" });
+	session.SetHeader(cpr::Header{ {"X-API-KEY", config_.api_key} });
+	session.SetTimeout(cpr::Timeout{ config_.timeout });
+	session.SetConnectTimeout(cpr::ConnectTimeout{ config_.connect_timeout });
+
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this] { return !running_ || !ready_.empty(); });
+			if (!running_) return;
+
+			// Take one job from the oldest caller, then send that caller to
+			// the back of the line if it still has work queued.
+			auto batch = std::move(ready_.front());
+			ready_.pop_front();
+			job = std::move(batch->jobs.front());
+			batch->jobs.pop_front();
+			if (!batch->jobs.empty())
+				ready_.push_back(std::move(batch));
+		}
+
+		nlohmann::json chain;
+		std::exception_ptr error;
+		try {
+			chain = perform(session, job.symbol);
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		job.complete(error, std::move(chain));
+	}
+}
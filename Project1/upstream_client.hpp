@@ -0,0 +1,91 @@
+#ifndef UPSTREAM_CLIENT_HPP
+#define UPSTREAM_CLIENT_HPP
+
+#include <nlohmann/json.hpp>
+#include <cpr/cpr.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct UpstreamConfig {
+	std::string base_url = "http://localhost:8000";
+	std::string api_key;
+	size_t pool_size = 8;                                 // keep-alive connections / I/O threads
+	std::chrono::milliseconds timeout{ 60000 };           // whole request, above a cold yfinance fetch
+	std::chrono::milliseconds connect_timeout{ 1000 };
+	int max_retries = 2;                                  // on connection failures, 429 and 5xx
+	std::chrono::milliseconds backoff{ 200 };             // doubled after each attempt
+};
+
+// Reads UPSTREAM_URL, API_KEY, UPSTREAM_POOL, UPSTREAM_TIMEOUT_MS,
+// UPSTREAM_CONNECT_TIMEOUT_MS, UPSTREAM_RETRIES and UPSTREAM_BACKOFF_MS.
+// `default_pool` applies when UPSTREAM_POOL is unset.
+// Throws if API_KEY is found neither in .env nor in the environment.
+UpstreamConfig loadUpstreamConfig(size_t default_pool = 8);
+
+// Client for the Python /ticker endpoint. Each of the `pool_size` I/O threads
+// owns a cpr::Session, so the underlying connection is reused across calls
+// instead of reconnecting per request. Calls are queued per caller and the
+// I/O threads serve callers round-robin, so a wide multi-symbol query cannot
+// hold back single-symbol requests queued after it.
+//
+// Request timeouts are not retried: a cold fetch on the Python side keeps
+// running after the client gives up, so retrying would only start another
+// yfinance scrape.
+class UpstreamClient {
+public:
+	using ChainCallback = std::function<void(const std::string& symbol, nlohmann::json chain)>;
+	using DoneCallback = std::function<void(std::exception_ptr error)>;
+
+	explicit UpstreamClient(UpstreamConfig config);
+	~UpstreamClient();
+
+	UpstreamClient(const UpstreamClient&) = delete;
+	UpstreamClient& operator=(const UpstreamClient&) = delete;
+
+	std::future<nlohmann::json> fetchChainAsync(const std::string& symbol);
+	nlohmann::json fetchChain(const std::string& symbol);
+
+	// One request per symbol, all queued at once; returns immediately.
+	// `onChain` runs on an I/O thread as soon as each chain arrives, so the
+	// first symbol is scored while the others download. Calls for one fan-out
+	// never overlap and stop after the first failure (an exception thrown by
+	// `onChain` counts as one). `onDone` runs once, after every request has
+	// completed, with the first failure or null.
+	void fetchEachAsync(const std::vector<std::string>& symbols, ChainCallback onChain, DoneCallback onDone);
+
+	const UpstreamConfig& config() const { return config_; }
+
+private:
+	struct Job {
+		std::string symbol;
+		std::function<void(std::exception_ptr error, nlohmann::json chain)> complete;   // runs on the I/O thread
+	};
+
+	// Jobs submitted by one caller.
+	struct Batch {
+		std::deque<Job> jobs;
+	};
+
+	void submit(std::shared_ptr<Batch> batch);
+	nlohmann::json perform(cpr::Session& session, const std::string& symbol);
+	void ioLoop();
+
+	UpstreamConfig config_;
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::deque<std::shared_ptr<Batch>> ready_;   // batches with queued jobs, served round-robin
+	bool running_ = true;
+	std::vector<std::thread> threads_;
+};
+
+#endif